@@ -0,0 +1,42 @@
+#ifndef BOARDS_H
+#define BOARDS_H
+
+// The engine is specialised for each board size: "engine.c" is compiled once for every size from
+// "KNIGHTS_MIN_BOARD_SIZE" to "KNIGHTS_MAX_BOARD_SIZE", with "N" defined as the size (see "Makefile").  Each build
+// exports only its table of entry points, named for its size, through which the library's functions
+// ("knights_engine.c") reach it.
+
+#include <stdint.h>
+#include "knights_engine.h"
+
+#define SIZED(name, size) SIZED_(name, size) // The entry point "name" of the build for "size" (e.g., "knights_board_6")
+#define SIZED_(name, size) name##_##size
+
+typedef struct Knights_Board { // The library's functions (see "knights_engine.h") for one board size
+	int size;
+	Knights_Engine *(*create)(const Knights_Options *options);
+	void (*destroy)(Knights_Engine *engine);
+	int (*threads)(Knights_Engine *engine);
+	int (*processors)(Knights_Engine *engine);
+	void (*new_game)(Knights_Engine *engine);
+	int (*set_position)(Knights_Engine *engine, uint64_t white_pieces, uint64_t black_pieces, unsigned checks_and_turn);
+	int (*play)(Knights_Engine *engine, Knights_Move move);
+	Knights_Status (*status)(Knights_Engine *engine);
+	void (*position)(Knights_Engine *engine, Knights_Position *position);
+	int (*search)(Knights_Engine *engine, const Knights_Limits *limits, Knights_Progress progress, void *data, Knights_Result *result);
+	void (*stop)(Knights_Engine *engine);
+	long (*save_table)(Knights_Engine *engine, const char *path, int min_depth);
+	int (*load_table)(Knights_Engine *engine, const char *path, long *loaded);
+	void (*clear_table)(Knights_Engine *engine);
+	int (*open_proof_table)(Knights_Engine *engine, const char *path, long megabytes, int *resumed);
+	Knights_Status (*solve)(Knights_Engine *engine, long limit, long *positions);
+	int (*build_book)(Knights_Engine *engine, Knights_Status result, long limit, long *positions);
+	long (*write_book)(Knights_Engine *engine, const char *path);
+	int (*read_book)(Knights_Engine *engine, const char *path);
+	int (*book_move)(Knights_Engine *engine, Knights_Move *move);
+} Knights_Board;
+
+extern const Knights_Board knights_board_4, knights_board_5, knights_board_6, knights_board_7, knights_board_8;
+// Defined by the builds of "engine.c"; every engine begins with a pointer to the board of its size
+
+#endif
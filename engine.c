@@ -0,0 +1,1830 @@
+#define _GNU_SOURCE // For "pthread_setaffinity_np" and "sched_getaffinity"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "engine.h"
+
+static Packed_Pieces pack_pieces(Coord *knights, int number_of_knights, Coord *king, int rotate) {
+	Packed_Pieces squares[K];
+	Packed_Pieces packed = 0, square = 0;
+	for (int i = 0; i < number_of_knights; i++) { // Insertion sort
+		square = N * knights[i].row + knights[i].col;
+		if (rotate) square = N * N - 1 - square;
+		int j = i;
+		for (; j > 0 && squares[j-1] > square; j--) squares[j] = squares[j-1];
+		squares[j] = square;
+	}
+	for (int i = 0; i < number_of_knights; i++) {
+		packed = packed | ((squares[i] + 1) << (i * SQUARE_BITS)); // The +1 is there to prevent confusion between non-existent knights and knights located at (0, 0).
+	}
+	square = N * king->row + king->col;
+	if (rotate) square = N * N - 1 - square;
+	return packed | (square << (K * SQUARE_BITS));
+}
+
+static Compressed_Position compress_position(Position *pp) { // Associates each position with a unique tuple of integers
+	Packed_Pieces cmp_white = pack_pieces(pp->knights[WHITE], pp->number_of_knights[WHITE], &pp->kings[WHITE], 0);
+	Packed_Pieces cmp_black = pack_pieces(pp->knights[BLACK], pp->number_of_knights[BLACK], &pp->kings[BLACK], 0);
+	uint8_t checks_and_turn = (pp->turn) | (pp->checks[WHITE] << 1) | (pp->checks[BLACK] << 3);
+	return (Compressed_Position){cmp_white, cmp_black, checks_and_turn};
+}
+
+static Compressed_Position canonical_position(Position *pp, int *sign) {
+	Compressed_Position cmp = compress_position(pp);
+	Compressed_Position image; // Black's pieces, rotated, become White's and vice versa
+	image.white_pieces = pack_pieces(pp->knights[BLACK], pp->number_of_knights[BLACK], &pp->kings[BLACK], 1);
+	image.black_pieces = pack_pieces(pp->knights[WHITE], pp->number_of_knights[WHITE], &pp->kings[WHITE], 1);
+	image.checks_and_turn = (1 - pp->turn) | (pp->checks[BLACK] << 1) | (pp->checks[WHITE] << 3);
+	int image_first = image.white_pieces != cmp.white_pieces ? image.white_pieces < cmp.white_pieces :
+		image.black_pieces != cmp.black_pieces ? image.black_pieces < cmp.black_pieces :
+		image.checks_and_turn < cmp.checks_and_turn;
+	*sign = image_first ? -1 : 1;
+	return image_first ? image : cmp;
+}
+
+static Position decompress_position(Compressed_Position *cmp) {
+	Position position;
+	set_pieces(cmp->white_pieces, &position, WHITE);
+	set_pieces(cmp->black_pieces, &position, BLACK);
+	position.turn = cmp->checks_and_turn % 2;
+	uint8_t mask = 3;
+	position.checks[WHITE] = (cmp->checks_and_turn & (mask << 1)) >> 1;
+	position.checks[BLACK] = (cmp->checks_and_turn & (mask << 3)) >> 3;
+	position.in_check = 0;
+	position.checking_square = (Coord){0, 0};
+	for (int i = 0; i < position.number_of_knights[1 - position.turn]; i++) {
+		if (knight_attacks(&position.knights[1 - position.turn][i], &position.kings[position.turn])) {
+			position.in_check = 1;
+			position.checking_square = position.knights[1 - position.turn][i];
+		}
+	}
+	return position;
+}
+
+static void set_pieces(Packed_Pieces pieces, Position *pp, int color) {
+	Packed_Pieces mask = SQUARE_MASK;
+	Packed_Pieces knight_position = pieces & mask;
+	int i = 0;
+	while (knight_position != 0 && i < K) {
+		int row = (int)(knight_position - 1) / N;
+		int col = (int)(knight_position - 1) % N;
+		pp->knights[color][i] = (Coord){row, col};
+		i++;
+		knight_position = (pieces & (mask << (i * SQUARE_BITS))) >> (i * SQUARE_BITS);
+	}
+	pp->number_of_knights[color] = i;
+	Packed_Pieces king_position = (pieces & (mask << (K * SQUARE_BITS))) >> (K * SQUARE_BITS);
+	pp->kings[color] = (Coord){(int)king_position / N, (int)king_position % N};
+}
+
+static int valid_position(Position *pp) {
+	Coord squares[2 * N];
+	int count = 0;
+	for (int color = WHITE; color <= BLACK; color++) {
+		for (int i = 0; i < pp->number_of_knights[color]; i++) squares[count++] = pp->knights[color][i];
+		squares[count++] = pp->kings[color];
+	}
+	for (int i = 0; i < count; i++) {
+		if (squares[i].row < 0 || squares[i].row >= N || squares[i].col < 0 || squares[i].col >= N) return 0;
+		for (int j = 0; j < i; j++) {
+			if (equal_crd(squares + i, squares + j)) return 0;
+		}
+	}
+	return 1;
+}
+
+static Knights_Move export_move(Move *move) {
+	Coord start = move_start(*move), end = move_end(*move);
+	return (Knights_Move){start.row, start.col, end.row, end.col};
+}
+
+static Move import_move(Knights_Move *move) {
+	Coord start = {move->start_row, move->start_col}, end = {move->end_row, move->end_col};
+	return pack_move(&start, &end, 0);
+}
+
+static int hash(Knights_Engine *engine, Compressed_Position *compressed_position) {
+	int hash_table_size = engine->hash_table_size;
+	uint32_t result = (uint32_t)(compressed_position->white_pieces % hash_table_size);
+	result *= (compressed_position->black_pieces % hash_table_size);
+	result = (result * compressed_position->checks_and_turn) % hash_table_size;
+	return (int)result;
+}
+
+static int equal_cmp(Compressed_Position *p1, Compressed_Position *p2) {
+	return (p1->white_pieces == p2->white_pieces) && (p1->black_pieces == p2->black_pieces) && (p1->checks_and_turn == p2->checks_and_turn);
+}
+
+static int check_hash(Knights_Engine *engine, Compressed_Position *compressed_position, int depth, int *index) {
+	Evaluated_Position *hash_table = engine->hash_table;
+	pthread_mutex_t *mutex_table = engine->mutex_table;
+	int hash_table_size = engine->hash_table_size;
+	int p_hash = hash(engine, compressed_position);
+	int worst_index = p_hash;
+	int worst_depth = MAX_DEPTH + 1;
+	int evaluation;
+	for (int i = 0; i < HASH_DEPTH; i++) {
+		int index = (p_hash + i) % hash_table_size;
+		pthread_mutex_lock(mutex_table + index);
+		if (hash_table[index].evaluation != IN_PROGRESS) { // Do not overwrite pending evaluation
+			if (hash_table[index].depth < worst_depth) {
+				worst_depth = hash_table[index].depth;
+				worst_index = index;
+			}
+			if (equal_cmp(&hash_table[index].compressed_position, compressed_position) && hash_table[index].depth >= depth) {
+				evaluation = hash_table[index].evaluation;
+				for (int j = 0; j <= i; j++) pthread_mutex_unlock(mutex_table + (p_hash + j) % hash_table_size);
+				return evaluation;
+			}
+		}
+	}
+	if (worst_depth != MAX_DEPTH + 1) { // Space found in hash table
+		hash_table[worst_index].compressed_position = *compressed_position;
+		hash_table[worst_index].evaluation = IN_PROGRESS;
+		for (int i = 0; i < HASH_DEPTH; i++) pthread_mutex_unlock(mutex_table + (p_hash + i) % hash_table_size);
+		*index = worst_index;
+		return NOT_IN_HASH;
+	}
+	for (int i = 0; i < HASH_DEPTH; i++) pthread_mutex_unlock(mutex_table + (p_hash + i) % hash_table_size);
+	return HASH_FULL;
+}
+
+static void add_to_hash(Knights_Engine *engine, Compressed_Position *compressed_position, int evaluation, int depth, int index) {
+	Evaluated_Position *hash_table = engine->hash_table;
+	pthread_mutex_lock(engine->mutex_table + index);
+	hash_table[index].compressed_position = *compressed_position;
+	hash_table[index].evaluation = evaluation;
+	hash_table[index].depth = depth;
+	pthread_mutex_unlock(engine->mutex_table + index);
+}
+
+static void release_hash(Knights_Engine *engine, int index) {
+	pthread_mutex_lock(engine->mutex_table + index);
+	memset(engine->hash_table + index, 0, sizeof(Evaluated_Position)); // No position compresses to all zeros, since the kings would share a square
+	pthread_mutex_unlock(engine->mutex_table + index);
+}
+
+static int find_max_index(Evaluated_Move array[], int length) { // Length must be greater than zero
+	int max_index = 0;
+	int max = array[0].evaluation;
+	for (int i = 0; i < length; i++) {
+		if (array[i].evaluation >= max) {
+			max = array[i].evaluation;
+			max_index = i;
+		}
+	}
+	return max_index;
+}
+
+static int find_min_index(Evaluated_Move array[], int length) { // Length must be greater than zero
+	int min_index = 0;
+	int min = array[0].evaluation;
+	for (int i = 0; i < length; i++) {
+		if (array[i].evaluation <= min) {
+			min = array[i].evaluation;
+			min_index = i;
+		}
+	}
+	return min_index;
+}
+
+static int knight_attacks(Coord *knight_position, Coord *coord) {
+	int row_difference = abs(knight_position->row - coord->row);
+	int col_difference = abs(knight_position->col - coord->col);
+	return (row_difference == 2 && col_difference == 1) || (row_difference == 1 && col_difference == 2);
+}
+
+static int king_attacks(Coord *king_position, Coord *coord) {
+	int row_difference = abs(king_position->row - coord->row);
+	int col_difference = abs(king_position->col - coord->col);
+	return row_difference <= 1 && col_difference <= 1;
+}
+
+static int is_protected(Position *pp, Coord *coord) { // Check to see whether checking piece is defended by another piece
+	if (king_attacks(&(pp->kings[1 - pp->turn]), coord)) return 1;
+	for (int i = 0; i < pp->number_of_knights[1 - pp->turn]; i++) {
+		if (knight_attacks(&(pp->knights[1 - pp->turn][i]), coord)) return 1;
+	}
+	return 0;
+}
+
+static int occupied_by(Position *pp, Coord *coord) {
+	if (coord->row == pp->kings[pp->turn].row && coord->col == pp->kings[pp->turn].col) return K;
+	for (int i = 0; i < pp->number_of_knights[pp->turn]; i++) {
+		if (coord->row == pp->knights[pp->turn][i].row && coord->col == pp->knights[pp->turn][i].col) return i;
+	}
+	return -1;
+}
+
+static int occupied_opponent(Position *pp, Coord *coord) {
+	for (int i = 0; i < pp->number_of_knights[1-pp->turn]; i++) {
+		if (coord->row == pp->knights[1-pp->turn][i].row && coord->col == pp->knights[1-pp->turn][i].col) return 1;
+	}
+	return 0;
+}
+
+static int get_knight_moves(Position *pp, Coord *coord, Coord *move_array) {
+	int i = 0;
+	Coord possible_moves[8] = { {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1} };
+	for (int j = 0; j < 8; j++) {
+		int new_row = coord->row - possible_moves[j].row;
+		int new_col = coord->col - possible_moves[j].col;
+		Coord new_coord = { new_row, new_col };
+		if (0 <= new_row && new_row < N && 0 <= new_col && new_col < N && occupied_by(pp, &new_coord) == -1) {
+			move_array[i].row = new_row;
+			move_array[i].col = new_col;
+			i++;
+		}
+	}
+	return i;
+}
+
+static int get_king_moves(Position *pp, Coord *move_array) {
+	int i = 0;
+	Coord possible_moves[8] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+	for (int j = 0; j < 8; j++) {
+		int new_row = pp->kings[pp->turn].row - possible_moves[j].row;
+		int new_col = pp->kings[pp->turn].col - possible_moves[j].col;
+		Coord new_coord = {new_row, new_col};
+		if (0 <= new_row && new_row < N && 0 <= new_col && new_col < N && occupied_by(pp, &new_coord) == -1 && !is_protected(pp, &new_coord)) {
+			if (move_array != NULL) {
+				move_array[i].row = new_row;
+				move_array[i].col = new_col;
+			}
+			i++;
+		}
+	}
+	return i;
+}
+
+static Move pack_move(Coord *start, Coord *end, int value) {
+	return (Move)((N * start->row + start->col) | ((N * end->row + end->col) << MOVE_SQUARE_BITS) | (value << MOVE_VALUE_SHIFT));
+}
+
+static Coord move_start(Move move) {
+	int square = move & MOVE_SQUARE_MASK;
+	return (Coord){square / N, square % N};
+}
+
+static Coord move_end(Move move) {
+	int square = (move >> MOVE_SQUARE_BITS) & MOVE_SQUARE_MASK;
+	return (Coord){square / N, square % N};
+}
+
+static int move_value(Move move) {
+	return (move >> MOVE_VALUE_SHIFT) & MOVE_VALUE_MASK;
+}
+
+static int ev(Position *pp, Coord *start, Coord *end, Move_Type move_type, Mode mode) {
+	if (mode == THREE_CHECKS) {
+		if (move_type == KING_MOVE) return occupied_opponent(pp, end);
+		if (move_type == KNIGHT_MOVE) return occupied_opponent(pp, end) + knight_attacks(end, &(pp->kings[1-pp->turn]));
+	}
+	if (mode == KINGS_CROSS) {
+		if (move_type == KING_MOVE) {
+			int rows_forward = (pp->turn == WHITE) ? start->row - end->row : end->row - start->row;
+			return occupied_opponent(pp, end) + rows_forward + 1;
+		}
+		if (move_type == KNIGHT_MOVE) return occupied_opponent(pp, end) + 1;
+	}
+	return 0;
+}
+
+static int get_moves(Position *pp, Evaluated_Move *mp, Mode mode) {
+	Coord move_array[8];
+	Move tmp_array[8 * (K+1)];
+	int n = 0;
+	if (pp->in_check) {
+		// Determine whether checking knight can be captured by knight
+		for (int i = 0; i < pp->number_of_knights[pp->turn]; i++) {
+			Coord *start = &(pp->knights[pp->turn][i]);
+			Coord *end = &(pp->checking_square);
+			if (knight_attacks(start, end)) {
+				tmp_array[n++] = pack_move(start, end, ev(pp, start, end, KNIGHT_MOVE, mode));
+			}
+		}
+	}
+	else {
+		for (int i = 0; i < pp->number_of_knights[pp->turn]; i++) {
+			Coord *start = &(pp->knights[pp->turn][i]);
+			int number_of_possible_moves = get_knight_moves(pp, start, move_array);
+			for (int j = 0; j < number_of_possible_moves; j++) {
+				tmp_array[n++] = pack_move(start, move_array + j, ev(pp, start, move_array + j, KNIGHT_MOVE, mode));
+			}
+		}
+	}
+	int number_of_possible_moves = get_king_moves(pp, move_array);
+	Coord *start = &(pp->kings[pp->turn]);
+	for (int j = 0; j < number_of_possible_moves; j++) {
+		tmp_array[n++] = pack_move(start, move_array + j, ev(pp, start, move_array + j, KING_MOVE, mode));
+	}
+	int count[POSSIBLE_VALUES] = {0};
+	int first[POSSIBLE_VALUES]; // Index in "mp" of the next move of each value, the most valuable coming first
+	for (int i = 0; i < n; i++) count[move_value(tmp_array[i])]++;
+	first[POSSIBLE_VALUES - 1] = 0;
+	for (int value = POSSIBLE_VALUES - 2; value >= 0; value--) first[value] = first[value + 1] + count[value + 1];
+	for (int i = 0; i < n; i++) mp[first[move_value(tmp_array[i])]++].move = tmp_array[i];
+	return n;
+}
+
+static int move_knight(Position *pp_new, Coord *start, Coord *end) {
+	for (int i = 0; i < pp_new->number_of_knights[1 - pp_new->turn]; i++) {
+		if (start->row == pp_new->knights[1 - pp_new->turn][i].row && start->col == pp_new->knights[1 - pp_new->turn][i].col) {
+			pp_new->knights[1 - pp_new->turn][i].row = end->row;
+			pp_new->knights[1 - pp_new->turn][i].col = end->col;
+			return knight_attacks(end, &(pp_new->kings[pp_new->turn]));
+		}
+	}
+	return -1;
+}
+
+static void make_move(Position *pp_old, Position *pp_new, Move *move) {
+	Coord start = move_start(*move), end = move_end(*move);
+	*pp_new = *pp_old;
+	pp_new->turn = 1 - pp_old->turn;
+	// Remove knight occupying destination square, if any
+	int occupier = occupied_by(pp_new, &end);
+	if (occupier != -1) {
+		for (int i = occupier; i < pp_new->number_of_knights[pp_new->turn] - 1; i++) {
+			pp_new->knights[pp_new->turn][i] = pp_new->knights[pp_new->turn][i+1];
+		}
+		pp_new->number_of_knights[pp_new->turn]--;
+	}
+	// Move piece from source square to destination square
+	if (start.row == pp_old->kings[pp_old->turn].row && start.col == pp_old->kings[pp_old->turn].col) {
+		pp_new->kings[pp_old->turn] = end;
+		pp_new->in_check = 0;
+	}
+	else {
+		pp_new->in_check = move_knight(pp_new, &start, &end);
+		pp_new->checking_square = end;
+		pp_new->checks[pp_new->turn] -= pp_new->in_check;
+	}
+}
+
+static void play_move(Knights_Engine *engine, Move *move) {
+	Position new_position;
+	make_move(&engine->position, &new_position, move);
+	engine->position = new_position;
+	if (engine->move_number < MAX_MOVES) engine->position_history[engine->move_number++] = compress_position(&new_position);
+}
+
+static int game_over(Position *pp, int available_moves, int *flag, Mode mode) {
+	if (mode == THREE_CHECKS) {
+		if (pp->checks[WHITE] == 0) {
+			*flag = BLACK_WINS;
+			return 1;
+		}
+		if (pp->checks[BLACK] == 0) {
+			*flag = WHITE_WINS;
+			return 1;
+		}
+		if (available_moves == 0) {
+			if (pp->in_check) {
+				if (pp->turn == WHITE) *flag = BLACK_WINS;
+				else *flag = WHITE_WINS;
+			}
+			else *flag = DRAW;
+			return 1;
+		}
+		if (pp->number_of_knights[WHITE] == 0 && pp->number_of_knights[BLACK] == 0) {
+			*flag = DRAW;
+			return 1;
+		}
+		return 0;
+	}
+	if (mode == KINGS_CROSS) {
+		if (pp->kings[WHITE].row == 0) {
+			*flag = WHITE_WINS;
+			return 1;
+		}
+		if (pp->kings[BLACK].row == N-1) {
+			*flag = BLACK_WINS;
+			return 1;
+		}
+		if (available_moves == 0) {
+			*flag = (pp->in_check) ? ((pp->turn == WHITE) ? BLACK_WINS : WHITE_WINS) : DRAW;
+			return 1;
+		}
+		return 0;
+	}
+	return 0;
+}
+
+static int game_result(Knights_Engine *engine, int *flag) {
+	Evaluated_Move em_array[8 * N];
+	Position *pp = &engine->position;
+	if (engine->move_number == MAX_MOVES) {
+		*flag = DRAW;
+		return 1;
+	}
+	if (game_over(pp, get_moves(pp, em_array, engine->mode), flag, engine->mode)) return 1;
+	int count = 0;
+	for (int i = 0; i < engine->move_number - 1; i++) {
+		count += equal_cmp(engine->position_history + i, engine->position_history + (engine->move_number - 1));
+		if (count == 2) { // Position has occurred two times before
+			*flag = DRAW;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int evaluate_position(Position *pp, Mode mode) {
+	if (mode == THREE_CHECKS) {
+		return (2 * pp->number_of_knights[0] + pp->checks[0]) - (2 * pp->number_of_knights[1] + pp->checks[1]);
+	}
+	if (mode == KINGS_CROSS) {
+		return (2 * pp->number_of_knights[WHITE] + (N - pp->kings[WHITE].row)) - (2 * pp->number_of_knights[BLACK] + pp->kings[BLACK].row + 1);
+	}
+	return 0;
+}
+
+static int evaluate_leaves(Search_Context *sc, Position *pp, Evaluated_Move *em_array, int n, Move *mp, int alpha, int beta) {
+	Leaf_Batch *lb = &sc->leaf_batch;
+	int mover = pp->turn;
+	int opponent = 1 - pp->turn;
+	int king_square = N * pp->kings[mover].row + pp->kings[mover].col;
+	for (int i = 0; i < n; i++) { // Only the moving side's king and the opponent's knights and checks can change
+		Coord end = move_end(em_array[i].move);
+		int king_move = (em_array[i].move & MOVE_SQUARE_MASK) == king_square;
+		lb->knights[mover][i] = pp->number_of_knights[mover];
+		lb->knights[opponent][i] = pp->number_of_knights[opponent] - occupied_opponent(pp, &end);
+		lb->checks[mover][i] = pp->checks[mover];
+		lb->checks[opponent][i] = pp->checks[opponent] - (!king_move && knight_attacks(&end, &pp->kings[opponent]));
+		lb->king_rows[mover][i] = king_move ? end.row : pp->kings[mover].row;
+		lb->king_rows[opponent][i] = pp->kings[opponent].row;
+	}
+	int min, max;
+	score_leaf_batch(lb, n, &min, &max, sc->engine->mode);
+	int best = (pp->turn == WHITE) ? max : min;
+	if ((pp->turn == WHITE && best >= beta) || (pp->turn == BLACK && best <= alpha)) {
+		// Every leaf was scored, but only those up to the first which refutes the position count as evaluated, as
+		// they would be if searched one at a time, so that the number of positions evaluated remains comparable
+		int visited = 1;
+		while (pp->turn == WHITE ? lb->evaluations[visited - 1] < beta : lb->evaluations[visited - 1] > alpha) visited++;
+		sc->positions_evaluated += visited;
+		return (pp->turn == WHITE) ? BETA_REJECT : ALPHA_REJECT;
+	}
+	sc->positions_evaluated += n;
+	for (int i = n - 1; i >= 0; i--) { // Ties go to the last move, as in "find_max_index" and "find_min_index"
+		if (lb->evaluations[i] == best) {
+			*mp = em_array[i].move;
+			break;
+		}
+	}
+	return best;
+}
+
+static void score_leaf_batch(Leaf_Batch *lb, int n, int *min, int *max, Mode mode) { // "n" must be greater than zero
+	// Both evaluation functions (see "evaluate_position") have the form
+	// 2 * (knights[WHITE] - knights[BLACK]) + check_weight * (checks[WHITE] - checks[BLACK]) - row_weight * (king_rows[WHITE] + king_rows[BLACK]) + constant
+	int16_t check_weight = (mode == THREE_CHECKS) ? 1 : 0;
+	int16_t row_weight = (mode == KINGS_CROSS) ? 1 : 0;
+	int16_t constant = (mode == KINGS_CROSS) ? N - 1 : 0;
+	int i = 0;
+	int best_max = ALPHA_REJECT, best_min = BETA_REJECT;
+#if defined(__AVX2__)
+	__m256i check_weights = _mm256_set1_epi16(check_weight), row_weights = _mm256_set1_epi16(row_weight), constants = _mm256_set1_epi16(constant);
+	__m256i max_vector = _mm256_set1_epi16(ALPHA_REJECT), min_vector = _mm256_set1_epi16(BETA_REJECT);
+	for (; i + 16 <= n; i += 16) {
+		__m256i knights = _mm256_sub_epi16(_mm256_load_si256((__m256i *)(lb->knights[WHITE] + i)), _mm256_load_si256((__m256i *)(lb->knights[BLACK] + i)));
+		__m256i checks = _mm256_sub_epi16(_mm256_load_si256((__m256i *)(lb->checks[WHITE] + i)), _mm256_load_si256((__m256i *)(lb->checks[BLACK] + i)));
+		__m256i rows = _mm256_add_epi16(_mm256_load_si256((__m256i *)(lb->king_rows[WHITE] + i)), _mm256_load_si256((__m256i *)(lb->king_rows[BLACK] + i)));
+		__m256i evaluations = _mm256_add_epi16(_mm256_add_epi16(knights, knights), _mm256_mullo_epi16(checks, check_weights));
+		evaluations = _mm256_add_epi16(_mm256_sub_epi16(evaluations, _mm256_mullo_epi16(rows, row_weights)), constants);
+		_mm256_store_si256((__m256i *)(lb->evaluations + i), evaluations);
+		max_vector = _mm256_max_epi16(max_vector, evaluations);
+		min_vector = _mm256_min_epi16(min_vector, evaluations);
+	}
+	_Alignas(32) int16_t lanes[2][16];
+	_mm256_store_si256((__m256i *)lanes[0], max_vector);
+	_mm256_store_si256((__m256i *)lanes[1], min_vector);
+	for (int j = 0; j < 16; j++) {
+		if (lanes[0][j] > best_max) best_max = lanes[0][j];
+		if (lanes[1][j] < best_min) best_min = lanes[1][j];
+	}
+#elif defined(__SSE2__)
+	__m128i check_weights = _mm_set1_epi16(check_weight), row_weights = _mm_set1_epi16(row_weight), constants = _mm_set1_epi16(constant);
+	__m128i max_vector = _mm_set1_epi16(ALPHA_REJECT), min_vector = _mm_set1_epi16(BETA_REJECT);
+	for (; i + 8 <= n; i += 8) {
+		__m128i knights = _mm_sub_epi16(_mm_load_si128((__m128i *)(lb->knights[WHITE] + i)), _mm_load_si128((__m128i *)(lb->knights[BLACK] + i)));
+		__m128i checks = _mm_sub_epi16(_mm_load_si128((__m128i *)(lb->checks[WHITE] + i)), _mm_load_si128((__m128i *)(lb->checks[BLACK] + i)));
+		__m128i rows = _mm_add_epi16(_mm_load_si128((__m128i *)(lb->king_rows[WHITE] + i)), _mm_load_si128((__m128i *)(lb->king_rows[BLACK] + i)));
+		__m128i evaluations = _mm_add_epi16(_mm_add_epi16(knights, knights), _mm_mullo_epi16(checks, check_weights));
+		evaluations = _mm_add_epi16(_mm_sub_epi16(evaluations, _mm_mullo_epi16(rows, row_weights)), constants);
+		_mm_store_si128((__m128i *)(lb->evaluations + i), evaluations);
+		max_vector = _mm_max_epi16(max_vector, evaluations);
+		min_vector = _mm_min_epi16(min_vector, evaluations);
+	}
+	_Alignas(16) int16_t lanes[2][8];
+	_mm_store_si128((__m128i *)lanes[0], max_vector);
+	_mm_store_si128((__m128i *)lanes[1], min_vector);
+	for (int j = 0; j < 8; j++) {
+		if (lanes[0][j] > best_max) best_max = lanes[0][j];
+		if (lanes[1][j] < best_min) best_min = lanes[1][j];
+	}
+#endif
+	for (; i < n; i++) { // Remaining moves (or all of them, if no SIMD instructions are available)
+		int evaluation = 2 * (lb->knights[WHITE][i] - lb->knights[BLACK][i]) + check_weight * (lb->checks[WHITE][i] - lb->checks[BLACK][i]);
+		evaluation += constant - row_weight * (lb->king_rows[WHITE][i] + lb->king_rows[BLACK][i]);
+		lb->evaluations[i] = evaluation;
+		if (evaluation > best_max) best_max = evaluation;
+		if (evaluation < best_min) best_min = evaluation;
+	}
+	*max = best_max;
+	*min = best_min;
+}
+
+static int acquire_thread(Knights_Engine *engine) {
+	int reclaimed = 0;
+	pthread_mutex_lock(&engine->thread_lock);
+	while (engine->threads_running >= engine->number_of_threads || (engine->threads_running > 0 && host_busy(engine))) {
+		if (engine->host == NULL) pthread_cond_wait(&engine->thread_finished, &engine->thread_lock);
+		else if (!reclaimed && engine->threads_running < engine->number_of_threads) {
+			// The host may only seem busy because of processes which exited while running threads, so once per wait,
+			// their slots are freed (without holding the lock, which the engine's other threads need to finish)
+			pthread_mutex_unlock(&engine->thread_lock);
+			reclaim_host_slots(engine);
+			reclaimed = 1;
+			pthread_mutex_lock(&engine->thread_lock);
+		}
+		else { // Threads finishing in other processes do not signal, so look again after a while
+			struct timespec wake;
+			clock_gettime(CLOCK_REALTIME, &wake);
+			wake.tv_nsec += HOST_POLL;
+			wake.tv_sec += wake.tv_nsec / 1000000000;
+			wake.tv_nsec %= 1000000000;
+			pthread_cond_timedwait(&engine->thread_finished, &engine->thread_lock, &wake);
+		}
+	}
+	engine->threads_running++;
+	if (engine->host != NULL) __atomic_add_fetch(&engine->host_slot->threads, 1, __ATOMIC_SEQ_CST);
+	int slot = 0;
+	while (engine->slot_taken[slot]) slot++;
+	engine->slot_taken[slot] = 1;
+	pthread_mutex_unlock(&engine->thread_lock);
+	return slot;
+}
+
+static void release_thread(Knights_Engine *engine, int slot) {
+	pthread_mutex_lock(&engine->thread_lock);
+	engine->threads_running--;
+	if (engine->host != NULL) __atomic_sub_fetch(&engine->host_slot->threads, 1, __ATOMIC_SEQ_CST);
+	engine->slot_taken[slot] = 0;
+	if (engine->pinned[slot] != -1) {
+		int32_t own_pid = getpid();
+		__atomic_compare_exchange_n(engine->host->processors + engine->pinned[slot], &own_pid, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		engine->pinned[slot] = -1;
+	}
+	pthread_cond_signal(&engine->thread_finished);
+	pthread_mutex_unlock(&engine->thread_lock);
+}
+
+static int host_busy(Knights_Engine *engine) {
+	if (engine->host == NULL) return 0;
+	int running = 0;
+	for (int i = 0; i < HOST_SLOTS; i++) {
+		Host_Slot *slot = engine->host->slots + i;
+		if (__atomic_load_n(&slot->pid, __ATOMIC_SEQ_CST) != 0) running += __atomic_load_n(&slot->threads, __ATOMIC_SEQ_CST);
+	}
+	return running >= engine->host_threads;
+}
+
+static void reclaim_host_slots(Knights_Engine *engine) {
+	for (int i = 0; i < HOST_SLOTS; i++) {
+		Host_Slot *slot = engine->host->slots + i;
+		int32_t pid = __atomic_load_n(&slot->pid, __ATOMIC_SEQ_CST);
+		if (pid == 0 || __atomic_load_n(&slot->threads, __ATOMIC_SEQ_CST) == 0) continue;
+		// Its process exited without leaving the budget (or is in another PID namespace, which cannot be told apart)
+		if (kill(pid, 0) == -1 && errno == ESRCH) {
+			__atomic_compare_exchange_n(&slot->pid, &pid, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+		}
+	}
+}
+
+static int open_host_budget(Knights_Engine *engine, const char *name) {
+	int fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+	struct stat st;
+	if (fd == -1) return 0;
+	// Every process extends the object to the same size, which leaves it zero-filled (all slots free) the first time
+	if (fstat(fd, &st) == -1 || (st.st_size < (off_t)sizeof(Host_Budget) && ftruncate(fd, sizeof(Host_Budget)) == -1)) {
+		close(fd);
+		return 0;
+	}
+	Host_Budget *host = mmap(NULL, sizeof(Host_Budget), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (host == MAP_FAILED) return 0;
+	uint32_t magic = 0;
+	if (!__atomic_compare_exchange_n(&host->magic, &magic, HOST_MAGIC, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) && magic != HOST_MAGIC) {
+		munmap(host, sizeof(Host_Budget));
+		return 0;
+	}
+	int32_t own_pid = getpid();
+	for (int i = 0; i < HOST_SLOTS; i++) { // Take a free slot, or one left by a process which has exited
+		Host_Slot *slot = host->slots + i;
+		int32_t pid = __atomic_load_n(&slot->pid, __ATOMIC_SEQ_CST);
+		if (pid != 0 && !(kill(pid, 0) == -1 && errno == ESRCH)) continue;
+		if (!__atomic_compare_exchange_n(&slot->pid, &pid, own_pid, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) continue;
+		__atomic_store_n(&slot->threads, 0, __ATOMIC_SEQ_CST);
+		engine->host = host;
+		engine->host_slot = slot;
+		return 1;
+	}
+	munmap(host, sizeof(Host_Budget));
+	return 0;
+}
+
+static void close_host_budget(Knights_Engine *engine) {
+	if (engine->host == NULL) return;
+	__atomic_store_n(&engine->host_slot->threads, 0, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&engine->host_slot->pid, 0, __ATOMIC_SEQ_CST);
+	munmap(engine->host, sizeof(Host_Budget));
+	engine->host = NULL;
+}
+
+static void pin_thread(Knights_Engine *engine, int slot) {
+	if (!engine->pin_threads || engine->processor_count == 0) return;
+	int processor = engine->processors[slot % engine->processor_count];
+	if (engine->host != NULL) { // Engines sharing the host would otherwise all pin their first threads to the same processors
+		processor = take_processor(engine);
+		if (processor == -1) return;
+		engine->pinned[slot] = processor;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(processor, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // If this fails, the thread simply runs unpinned
+}
+
+static int take_processor(Knights_Engine *engine) {
+	int32_t own_pid = getpid();
+	for (int reclaim = 0; reclaim < 2; reclaim++) { // Free processors first, and only then those of exited processes
+		for (int i = 0; i < engine->processor_count; i++) {
+			int processor = engine->processors[i];
+			if (processor >= HOST_PROCESSORS) continue;
+			int32_t pid = __atomic_load_n(engine->host->processors + processor, __ATOMIC_SEQ_CST);
+			if (pid != 0 && !(reclaim && kill(pid, 0) == -1 && errno == ESRCH)) continue;
+			if (__atomic_compare_exchange_n(engine->host->processors + processor, &pid, own_pid, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) return processor;
+		}
+	}
+	return -1;
+}
+
+static void *get_best_move_wrapper(void *position_depth_and_ptrs) {
+	PDP args = *((PDP *)position_depth_and_ptrs);
+	Move best_response;
+	pin_thread(args.sc->engine, args.slot);
+	(*(args.ptr)).evaluation = find_best_move(args.sc, args.pp, &best_response, args.alpha, args.beta, args.depth, 1);
+	release_thread(args.sc->engine, args.slot);
+	return NULL;
+}
+
+static void search_moves(Knights_Engine *engine, Position *pp, Evaluated_Move *em_array, int *indices, int count, int alpha, int beta, int depth) {
+	if (count == 0) return;
+	Position position_after_move[count];
+	pthread_t tid[count];
+	PDP args[count];
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+	for (int j = 0; j < count; j++) {
+		int i = indices[j];
+		int slot = acquire_thread(engine);
+		make_move(pp, position_after_move + j, &em_array[i].move);
+		engine->search_contexts[i].positions_evaluated = 0;
+		args[j] = (PDP){position_after_move + j, depth, em_array + i, engine->search_contexts + i, alpha, beta, slot};
+		pthread_create(tid + j, &attr, get_best_move_wrapper, (void *)(args + j));
+	}
+	for (int j = 0; j < count; j++) {
+		pthread_join(tid[j], NULL);
+		engine->positions_evaluated += engine->search_contexts[indices[j]].positions_evaluated;
+	}
+	pthread_attr_destroy(&attr);
+}
+
+static void sort_moves(Evaluated_Move *em_array, int *indices, int count, int turn) {
+	for (int i = 1; i < count; i++) { // Insertion sort; stable, so that ties keep the order given by "get_moves"
+		int index = indices[i];
+		int evaluation = em_array[index].evaluation;
+		int j = i;
+		for (; j > 0 && (turn == WHITE ? em_array[indices[j-1]].evaluation < evaluation : em_array[indices[j-1]].evaluation > evaluation); j--) {
+			indices[j] = indices[j-1];
+		}
+		indices[j] = index;
+	}
+}
+
+static int search_multi_pv(Knights_Engine *engine, Position *pp, Evaluated_Move *em_array, int *indices, int n, int depth, int multi_pv) {
+	int k = (multi_pv < n) ? multi_pv : n;
+	search_moves(engine, pp, em_array, indices, k, ALPHA_REJECT, BETA_REJECT, depth);
+	sort_moves(em_array, indices, k, pp->turn);
+	int count = k; // Moves evaluated exactly, followed in "indices" by those rejected, and then by those not yet searched
+	// The remaining moves are taken as many at a time as may run at once, and each need only be compared with the kth
+	// best so far, using a null window which tells whether it is at least as good.  Only those which are are searched
+	// again to find their exact evaluations, which may raise the kth best, and so narrow the search of the next moves.
+	for (int next = k; next < n && !engine->stop; ) {
+		int batch = (n - next < engine->number_of_threads) ? n - next : engine->number_of_threads;
+		int bound = em_array[indices[k-1]].evaluation;
+		int alpha = (pp->turn == WHITE) ? bound - 1 : bound;
+		search_moves(engine, pp, em_array, indices + next, batch, alpha, alpha + 1, depth);
+		int candidates = 0;
+		for (int j = next; j < next + batch; j++) {
+			int i = indices[j];
+			if (pp->turn == WHITE ? em_array[i].evaluation >= bound : em_array[i].evaluation <= bound) { // Ties may be chosen, so they are kept
+				indices[j] = indices[count + candidates];
+				indices[count + candidates++] = i;
+			}
+			else em_array[i].evaluation = (pp->turn == WHITE) ? ALPHA_REJECT : BETA_REJECT;
+		}
+		// A candidate is known to be at least as good as the bound, so its window need only extend the other way
+		if (pp->turn == WHITE) search_moves(engine, pp, em_array, indices + count, candidates, alpha, BETA_REJECT, depth);
+		else search_moves(engine, pp, em_array, indices + count, candidates, ALPHA_REJECT, alpha + 1, depth);
+		count += candidates;
+		sort_moves(em_array, indices, count, pp->turn);
+		next += batch;
+	}
+	return count;
+}
+
+static int search_position(Knights_Engine *engine, Position *pp, int depth, int multi_pv, Knights_Result *result) {
+	Evaluated_Move em_array[8 * N];
+	int n = get_moves(pp, em_array, engine->mode); // Number of moves
+	int indices[n];
+	int listed[n];
+	for (int i = 0; i < n; i++) {
+		indices[i] = i;
+		listed[i] = 0;
+	}
+	int count = n; // Number of moves evaluated exactly
+	if (multi_pv == 0) {
+		search_moves(engine, pp, em_array, indices, n, ALPHA_REJECT, BETA_REJECT, depth);
+		sort_moves(em_array, indices, n, pp->turn);
+	}
+	else count = search_multi_pv(engine, pp, em_array, indices, n, depth, multi_pv);
+	if (engine->stop) return 0;
+	result->move_count = 0;
+	for (int j = 0; j < n; j++) { // Moves evaluated exactly, best first, and then the rest
+		int i = (j < count) ? indices[j] : 0;
+		if (j >= count) {
+			while (listed[i]) i++;
+		}
+		listed[i] = 1;
+		Knights_Line *line = result->moves + result->move_count++;
+		Search_Context *sc = engine->search_contexts + i;
+		line->move = export_move(&em_array[i].move);
+		line->evaluation = em_array[i].evaluation;
+		line->exact = (j < count) && line->evaluation != ALPHA_REJECT && line->evaluation != BETA_REJECT;
+		line->length = line->exact ? sc->pv_length[1] : 0;
+		for (int k = 0; k < line->length; k++) line->line[k] = export_move(sc->pv[1] + k);
+	}
+	int ties = 0; // Number of moves as good as the best, among which one is chosen at random
+	int reported = (multi_pv > 0 && multi_pv < count) ? multi_pv : count; // The choice is made among the moves reported
+	while (ties < reported && result->moves[ties].evaluation == result->moves[0].evaluation) ties++;
+	int best = (ties > 0) ? arc4random() % ties : 0;
+	result->best_move = result->moves[best].move;
+	result->evaluation = result->moves[best].evaluation;
+	return 1;
+}
+
+static void update_pv(Search_Context *sc, int ply, Move *move) {
+	sc->pv[ply][0] = *move;
+	memcpy(sc->pv[ply] + 1, sc->pv[ply + 1], sc->pv_length[ply + 1] * sizeof(Move));
+	sc->pv_length[ply] = sc->pv_length[ply + 1] + 1;
+}
+
+static int find_best_move(Search_Context *sc, Position *pp, Move *mp, int alpha, int beta, int depth, int ply) { // Returns the evaluation of White's best move from the position "*pp"
+	sc->positions_evaluated++;
+	sc->pv_length[ply] = 0;
+	if (search_stopped(sc)) return ALPHA_REJECT; // The evaluation will be discarded
+	if (depth == 0) return evaluate_position(pp, sc->engine->mode);
+	Evaluated_Move *em_array = sc->move_stack[ply];
+	Position position_after_move;
+	int n = get_moves(pp, em_array, sc->engine->mode); // Number of candidate moves from current position
+	int flag; // Value of finished game (White win, Black win, or draw)
+	int shallow_best = (pp->turn == WHITE) ? ALPHA_REJECT : BETA_REJECT; // Best evaluation, at shallow depth, for a candidate move
+	if (game_over(pp, n, &flag, sc->engine->mode)) return flag;
+	if (depth == 1) {
+		int evaluation = evaluate_leaves(sc, pp, em_array, n, mp, alpha, beta);
+		if (evaluation != ALPHA_REJECT && evaluation != BETA_REJECT) {
+			sc->pv[ply][0] = *mp;
+			sc->pv_length[ply] = 1;
+		}
+		return evaluation;
+	}
+	int pv_index = -1; // Index of the best move found so far, whose line is stored in "sc->pv[ply]"
+	for (int i = 0; i < n; i++) { // Evaluate each possible move
+		make_move(pp, &position_after_move, &em_array[i].move);
+		if (depth >= SHALLOW_EXECUTION_DEPTH) {
+			if (i == 0) shallow_reject(sc, &position_after_move, ALPHA_REJECT, BETA_REJECT, &em_array[i].evaluation, &shallow_best, ply + 1);
+			else if (shallow_reject(sc, &position_after_move, alpha, beta, &em_array[i].evaluation, &shallow_best, ply + 1)) continue;
+		}
+		sc->pv_length[ply + 1] = 0; // No line is known for positions found in the hash table
+		int sign;
+		Compressed_Position compressed_position = canonical_position(&position_after_move, &sign);
+		int hash_index;
+		int evaluation = check_hash(sc->engine, &compressed_position, depth, &hash_index);
+		if (evaluation == NOT_IN_HASH) {
+			em_array[i].evaluation = find_best_move(sc, &position_after_move, mp, alpha, beta, depth - 1, ply + 1);
+			if (em_array[i].evaluation != ALPHA_REJECT && em_array[i].evaluation != BETA_REJECT && !sc->engine->stop) {
+				add_to_hash(sc->engine, &compressed_position, sign * em_array[i].evaluation, depth, hash_index);
+			}
+			else release_hash(sc->engine, hash_index);
+		}
+		else if (evaluation == HASH_FULL || evaluation == IN_PROGRESS) { // Proceed with evaluation, but do not add to hash
+			em_array[i].evaluation = find_best_move(sc, &position_after_move, mp, alpha, beta, depth - 1, ply + 1);
+		}
+		else { // Found in hash table
+			em_array[i].evaluation = sign * evaluation;
+		}
+		if (sc->engine->stop) return ALPHA_REJECT;
+		if (pp->turn == WHITE) {
+			if (em_array[i].evaluation >= beta) return BETA_REJECT; // Black should reject this branch
+			alpha = em_array[i].evaluation > alpha ? em_array[i].evaluation : alpha;
+		}
+		else {
+			if (em_array[i].evaluation <= alpha) return ALPHA_REJECT; // White should reject this branch
+			beta = em_array[i].evaluation < beta ? em_array[i].evaluation : beta;
+		}
+		if (pv_index == -1 || (pp->turn == WHITE ? em_array[i].evaluation >= em_array[pv_index].evaluation : em_array[i].evaluation <= em_array[pv_index].evaluation)) {
+			pv_index = i;
+			update_pv(sc, ply, &em_array[i].move);
+		}
+	}
+	int best_index = (pp->turn == WHITE) ? find_max_index(em_array, n) : find_min_index(em_array, n);
+	*mp = em_array[best_index].move;
+	if (best_index != pv_index) {
+		sc->pv[ply][0] = em_array[best_index].move;
+		sc->pv_length[ply] = 1;
+	}
+	// If every move was rejected, so is this position; the evaluation is only a bound, and must not be stored
+	if (em_array[best_index].evaluation == ALPHA_REJECT || em_array[best_index].evaluation == BETA_REJECT) return em_array[best_index].evaluation;
+	if (em_array[best_index].evaluation <= FORCED_WIN_BLACK) return em_array[best_index].evaluation + 1;
+	if (em_array[best_index].evaluation >= FORCED_WIN_WHITE) return em_array[best_index].evaluation - 1;
+	return em_array[best_index].evaluation;
+}
+
+static int shallow_reject(Search_Context *sc, Position *pp, int alpha, int beta, int16_t *flag, int *shallow_best, int ply) {
+	// We reject the position from the perspective of the side which has just moved (i.e., the side indicated by 1 - pp->turn)
+	Move best_move;
+	int evaluation = find_best_move(sc, pp, &best_move, ALPHA_REJECT, BETA_REJECT, SHALLOW_SEARCH_DEPTH, ply);
+	if (pp->turn == BLACK) {
+		if (evaluation < alpha && evaluation <= *shallow_best) {
+			*flag = ALPHA_REJECT;
+			return 1;
+		}
+		if (evaluation > *shallow_best) *shallow_best = evaluation;
+	}
+	if (pp->turn == WHITE) {
+		if (evaluation > beta && evaluation >= *shallow_best) {
+			*flag = BETA_REJECT;
+			return 1;
+		}
+		if (evaluation < *shallow_best) *shallow_best = evaluation;
+	}
+	return 0;
+}
+
+static int search_stopped(Search_Context *sc) {
+	Knights_Engine *engine = sc->engine;
+	if (engine->check_deadline && --sc->clock_countdown <= 0) {
+		struct timespec now;
+		sc->clock_countdown = CLOCK_INTERVAL;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > engine->deadline.tv_sec || (now.tv_sec == engine->deadline.tv_sec && now.tv_nsec >= engine->deadline.tv_nsec)) engine->stop = 1;
+	}
+	return engine->stop;
+}
+
+static void get_starting_position(Position *pp) {
+	int j = 0;
+	for (int i = 2; i < N; i++) {
+		pp->knights[WHITE][j] = (Coord){N-1, i};
+		pp->knights[BLACK][j] = (Coord){0, N-i-1};
+		j++;
+	}
+	pp->kings[WHITE] = (Coord){N-1, 0};
+	pp->kings[BLACK] = (Coord){0, N-1};
+	pp->checks[WHITE] = 3;
+	pp->checks[BLACK] = 3;
+	pp->number_of_knights[WHITE] = N-2;
+	pp->number_of_knights[BLACK] = N-2;
+	pp->turn = WHITE;
+	pp->in_check = 0;
+	pp->checking_square = (Coord){0, 0};
+}
+
+static int equal_crd(Coord *c1, Coord *c2) {
+	return c1->row == c2->row && c1->col == c2->col;
+}
+
+static void normalize_position(Position *pp, Mode mode) {
+	if (mode == KINGS_CROSS) { // Checks play no part in this variant, so positions differing only in them are the same
+		pp->checks[WHITE] = 3;
+		pp->checks[BLACK] = 3;
+	}
+}
+
+static Move rotate_move(Move *move) {
+	Coord start = move_start(*move), end = move_end(*move);
+	Coord rotated_start = {N - 1 - start.row, N - 1 - start.col}, rotated_end = {N - 1 - end.row, N - 1 - end.col};
+	return pack_move(&rotated_start, &rotated_end, move_value(*move));
+}
+
+static Compressed_Position solver_key(Position *pp, int attacker) {
+	int sign;
+	Compressed_Position key = canonical_position(pp, &sign);
+	// Proof and disproof numbers are relative to the side to move, and so are unchanged by the symmetry, provided
+	// the attacker changes sides along with the pieces
+	key.checks_and_turn |= (pp->turn == attacker) << 5;
+	return key;
+}
+
+static uint64_t table_hash(Compressed_Position *key) {
+	uint64_t h = (uint64_t)key->white_pieces * 0x9E3779B97F4A7C15ULL;
+	h ^= (uint64_t)key->black_pieces * 0xC2B2AE3D27D4EB4FULL;
+	h ^= (uint64_t)key->checks_and_turn * 0x165667B19E3779F9ULL;
+	return h ^ (h >> 31);
+}
+
+static int proof_lookup(Knights_Engine *engine, Compressed_Position *key, uint32_t *phi, uint32_t *delta) {
+	uint64_t bucket = table_hash(key) % (engine->proof_table_size / SOLVER_BUCKET);
+	Proof_Entry *entries = engine->proof_table + bucket * SOLVER_BUCKET;
+	int found = 0;
+	pthread_mutex_lock(engine->proof_locks + bucket % SOLVER_LOCKS);
+	for (int i = 0; i < SOLVER_BUCKET; i++) {
+		if (entries[i].work != 0 && equal_cmp(&entries[i].key, key)) {
+			*phi = entries[i].phi;
+			*delta = entries[i].delta;
+			found = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(engine->proof_locks + bucket % SOLVER_LOCKS);
+	return found;
+}
+
+static void proof_store(Knights_Engine *engine, Compressed_Position *key, uint32_t phi, uint32_t delta, uint32_t work) {
+	uint64_t bucket = table_hash(key) % (engine->proof_table_size / SOLVER_BUCKET);
+	Proof_Entry *entries = engine->proof_table + bucket * SOLVER_BUCKET;
+	int index = 0;
+	pthread_mutex_lock(engine->proof_locks + bucket % SOLVER_LOCKS);
+	for (int i = 0; i < SOLVER_BUCKET; i++) { // Prefer the slot holding this position, then an empty slot, then the least work
+		if (entries[i].work != 0 && equal_cmp(&entries[i].key, key)) {
+			index = i;
+			work += entries[i].work;
+			break;
+		}
+		if (entries[i].work < entries[index].work) index = i;
+	}
+	entries[index] = (Proof_Entry){*key, phi, delta, work > 0 ? work : 1};
+	pthread_mutex_unlock(engine->proof_locks + bucket % SOLVER_LOCKS);
+}
+
+static void solver_result(Solver_Context *ctx, Position *pp, int attacker_wins, uint32_t *phi, uint32_t *delta) {
+	if (attacker_wins == (pp->turn == ctx->attacker)) { // The side to move has achieved its aim
+		*phi = 0;
+		*delta = SOLVER_INFINITY;
+	}
+	else {
+		*phi = SOLVER_INFINITY;
+		*delta = 0;
+	}
+}
+
+static int solver_outcome(Solver_Context *ctx, Position *pp, uint32_t phi, uint32_t delta) {
+	if (phi == 0) return (pp->turn == ctx->attacker) ? 1 : -1;
+	if (delta == 0) return (pp->turn == ctx->attacker) ? -1 : 1;
+	return 0;
+}
+
+static int solver_repetition(Solver_Context *ctx, Position *pp) {
+	if (ctx->path_length >= MAX_MOVES - 1) return 1; // The game would be drawn before it could be won
+	Compressed_Position cmp = compress_position(pp);
+	for (int i = 0; i < ctx->path_length; i++) {
+		if (equal_cmp(ctx->path + i, &cmp)) return 1;
+	}
+	return 0;
+}
+
+static int solver_mid(Solver_Context *ctx, Position *pp, Compressed_Position *key, uint32_t th_phi, uint32_t th_delta, uint32_t *phi, uint32_t *delta) {
+	long start = ctx->positions_visited++;
+	Evaluated_Move em_array[8 * N];
+	int n = get_moves(pp, em_array, ctx->engine->mode);
+	int flag;
+	if (game_over(pp, n, &flag, ctx->engine->mode)) {
+		solver_result(ctx, pp, flag == ((ctx->attacker == WHITE) ? WHITE_WINS : BLACK_WINS), phi, delta);
+		proof_store(ctx->engine, key, *phi, *delta, 1);
+		return 0;
+	}
+	Position children[8 * N];
+	Compressed_Position keys[8 * N];
+	uint32_t child_phi[8 * N], child_delta[8 * N];
+	int dependent[8 * N]; // Whether the child's result depends on the line leading to it
+	ctx->path[ctx->path_length++] = compress_position(pp);
+	for (int i = 0; i < n; i++) {
+		make_move(pp, children + i, &em_array[i].move);
+		normalize_position(children + i, ctx->engine->mode);
+		keys[i] = solver_key(children + i, ctx->attacker);
+		dependent[i] = solver_repetition(ctx, children + i);
+		if (dependent[i]) solver_result(ctx, children + i, 0, child_phi + i, child_delta + i); // Counts as a draw
+		else if (!proof_lookup(ctx->engine, keys + i, child_phi + i, child_delta + i)) {
+			child_phi[i] = 1;
+			child_delta[i] = 1;
+		}
+	}
+	while (1) {
+		for (int i = 0; i < n && ctx->path_length <= SOLVER_SPLIT_DEPTH; i++) { // Other threads may have solved a child
+			uint32_t table_phi, table_delta;
+			if (dependent[i] || child_phi[i] == 0 || child_delta[i] == 0 || !proof_lookup(ctx->engine, keys + i, &table_phi, &table_delta)) continue;
+			if (table_phi == 0 || table_delta == 0) {
+				child_phi[i] = table_phi;
+				child_delta[i] = table_delta;
+			}
+		}
+		uint32_t min_delta = SOLVER_INFINITY, second_delta = SOLVER_INFINITY, sum_phi = 0;
+		int best = 0;
+		for (int i = 0; i < n; i++) {
+			// Short of a proof, the sum stays below infinity, which would otherwise be mistaken for one
+			sum_phi = (sum_phi + child_phi[i] < SOLVER_INFINITY - 1) ? sum_phi + child_phi[i] : SOLVER_INFINITY - 1;
+			if (child_delta[i] < min_delta) {
+				second_delta = min_delta;
+				min_delta = child_delta[i];
+				best = i;
+			}
+			else if (child_delta[i] < second_delta) second_delta = child_delta[i];
+		}
+		*phi = min_delta;
+		*delta = (min_delta == 0) ? SOLVER_INFINITY : sum_phi;
+		if (*phi >= th_phi || *delta >= th_delta || ctx->engine->solver_stop || ctx->engine->stop) break;
+		if (ctx->limit != 0 && ctx->positions_visited >= ctx->limit) break;
+		uint32_t child_th_phi = (th_delta == SOLVER_INFINITY) ? SOLVER_INFINITY : th_delta - (*delta - child_phi[best]);
+		// Letting the child run somewhat past the second-best sibling avoids switching back and forth between them
+		uint32_t child_th_delta = (second_delta + second_delta / SOLVER_SLACK + 1 < th_phi) ? second_delta + second_delta / SOLVER_SLACK + 1 : th_phi;
+		dependent[best] = solver_mid(ctx, children + best, keys + best, child_th_phi, child_th_delta, child_phi + best, child_delta + best);
+	}
+	ctx->path_length--;
+	// A win is never owed to a repetition, but a failure to win may be, and then holds only for the current line.  It
+	// is so if the attacker has no move whose failure holds regardless, or the defender has no such reply.
+	int result_dependent = 0;
+	if (solver_outcome(ctx, pp, *phi, *delta) == -1) {
+		result_dependent = (pp->turn != ctx->attacker);
+		for (int i = 0; i < n; i++) {
+			if (pp->turn == ctx->attacker && dependent[i]) result_dependent = 1;
+			if (pp->turn != ctx->attacker && !dependent[i] && solver_outcome(ctx, children + i, child_phi[i], child_delta[i]) == -1) result_dependent = 0;
+		}
+	}
+	if (!result_dependent) proof_store(ctx->engine, key, *phi, *delta, (uint32_t)(ctx->positions_visited - start));
+	return result_dependent;
+}
+
+static void *solver_wrapper(void *solver_args) {
+	Solver_Args args = *((Solver_Args *)solver_args);
+	Solver_Context *ctx = args.ctx;
+	Solver_Work *work = args.work;
+	Knights_Engine *engine = ctx->engine;
+	pin_thread(engine, args.slot);
+	while (!engine->solver_stop && !engine->stop) { // Each move from the root is solved by a single thread, until none is left
+		pthread_mutex_lock(&work->lock);
+		int i = work->next++;
+		pthread_mutex_unlock(&work->lock);
+		if (i >= work->n) break;
+		ctx->path_length = 1; // Only the root
+		solver_mid(ctx, work->children + i, work->keys + i, SOLVER_INFINITY, SOLVER_INFINITY, work->child_phi + i, work->child_delta + i);
+		int outcome = solver_outcome(ctx, work->children + i, work->child_phi[i], work->child_delta[i]);
+		pthread_mutex_lock(&work->lock);
+		// The root is decided once the attacker has a winning move, or the defender has a move that does not lose, or
+		// every move has been solved
+		if (++work->solved == work->n) engine->solver_stop = 1;
+		if ((outcome == 1 && work->root.turn == ctx->attacker) || (outcome == -1 && work->root.turn != ctx->attacker)) engine->solver_stop = 1;
+		pthread_mutex_unlock(&work->lock);
+	}
+	Position position;
+	Compressed_Position key;
+	while (!engine->solver_stop && !engine->stop) {
+		ctx->path_length = 0;
+		if (!solver_find_work(ctx, work, &work->root, 0, &position, &key)) break;
+		uint32_t phi, delta;
+		solver_mid(ctx, &position, &key, SOLVER_INFINITY, SOLVER_INFINITY, &phi, &delta);
+	}
+	release_thread(engine, args.slot);
+	return NULL;
+}
+
+static int solver_find_work(Solver_Context *ctx, Solver_Work *work, Position *pp, int depth, Position *found, Compressed_Position *key) {
+	if (depth == SOLVER_SPLIT_DEPTH) return 0;
+	Evaluated_Move em_array[8 * N];
+	int n = get_moves(pp, em_array, ctx->engine->mode);
+	int flag;
+	if (game_over(pp, n, &flag, ctx->engine->mode)) return 0;
+	Position children[8 * N];
+	Compressed_Position keys[8 * N];
+	int unresolved[8 * N]; // Children neither resolved nor repeated, all of which have been taken up
+	int count = 0;
+	ctx->path[ctx->path_length++] = compress_position(pp);
+	for (int i = 0; i < n; i++) {
+		make_move(pp, children + i, &em_array[i].move);
+		normalize_position(children + i, ctx->engine->mode);
+		keys[i] = solver_key(children + i, ctx->attacker);
+		uint32_t phi, delta;
+		if (solver_repetition(ctx, children + i)) continue;
+		if (proof_lookup(ctx->engine, keys + i, &phi, &delta) && (phi == 0 || delta == 0)) continue;
+		pthread_mutex_lock(&work->lock);
+		int taken = 0;
+		for (int j = 0; j < work->claim_count && !taken; j++) taken = equal_cmp(work->claims + j, keys + i);
+		if (!taken && work->claim_count < SOLVER_CLAIMS) work->claims[work->claim_count++] = keys[i];
+		pthread_mutex_unlock(&work->lock);
+		if (!taken) {
+			*found = children[i];
+			*key = keys[i];
+			return 1;
+		}
+		unresolved[count++] = i;
+	}
+	for (int j = 0; j < count; j++) {
+		if (solver_find_work(ctx, work, children + unresolved[j], depth + 1, found, key)) return 1;
+	}
+	ctx->path_length--;
+	return 0;
+}
+
+static int solve_for(Knights_Engine *engine, Position *pp, int attacker, long limit, long *positions_visited) {
+	Evaluated_Move em_array[8 * N];
+	Solver_Context root_ctx = {engine, attacker, 0, 0, 0};
+	int n = get_moves(pp, em_array, engine->mode);
+	int flag;
+	if (game_over(pp, n, &flag, engine->mode)) return (flag == ((attacker == WHITE) ? WHITE_WINS : BLACK_WINS)) ? 1 : -1;
+	Solver_Work *work = calloc(1, sizeof(Solver_Work));
+	int threads = (n < engine->number_of_threads) ? n : engine->number_of_threads;
+	Solver_Context *contexts = malloc(threads * sizeof(Solver_Context));
+	if (work == NULL || contexts == NULL) {
+		free(work);
+		free(contexts);
+		return 0;
+	}
+	if (limit > 0) root_ctx.limit = (limit + threads - 1) / threads; // Each thread takes an equal share
+	work->root = *pp;
+	work->n = n;
+	pthread_mutex_init(&work->lock, NULL);
+	root_ctx.path[root_ctx.path_length++] = compress_position(pp);
+	for (int i = 0; i < n; i++) {
+		make_move(pp, work->children + i, &em_array[i].move);
+		normalize_position(work->children + i, engine->mode);
+		work->keys[i] = solver_key(work->children + i, attacker);
+		work->claims[work->claim_count++] = work->keys[i]; // Taken up by the thread which solves the move
+		work->child_phi[i] = 1;
+		work->child_delta[i] = 1;
+	}
+	Solver_Args args[threads];
+	pthread_t tid[threads];
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+	engine->solver_stop = 0;
+	for (int i = 0; i < threads; i++) {
+		contexts[i] = root_ctx;
+		args[i] = (Solver_Args){contexts + i, work, acquire_thread(engine)};
+		pthread_create(tid + i, &attr, solver_wrapper, (void *)(args + i));
+	}
+	for (int i = 0; i < threads; i++) {
+		pthread_join(tid[i], NULL);
+		*positions_visited += contexts[i].positions_visited;
+	}
+	pthread_attr_destroy(&attr);
+	// The side to move achieves its aim with one move which does, and fails if every move fails; short of either,
+	// the threads stopped before the result was known
+	int aim = (pp->turn == attacker) ? 1 : -1, achieved = 0, failed = 0;
+	for (int i = 0; i < n; i++) {
+		int outcome = solver_outcome(&root_ctx, work->children + i, work->child_phi[i], work->child_delta[i]);
+		if (outcome == aim) achieved = 1;
+		if (outcome == -aim) failed++;
+	}
+	pthread_mutex_destroy(&work->lock);
+	free(work);
+	free(contexts);
+	int result = achieved ? aim : (failed == n) ? -aim : 0;
+	if (result == 0 || engine->stop) return 0; // The table keeps the numbers found so far, from which a later run resumes
+	uint32_t phi, delta;
+	solver_result(&root_ctx, pp, result == 1, &phi, &delta);
+	Compressed_Position key = solver_key(pp, attacker);
+	proof_store(engine, &key, phi, delta, 1);
+	return result;
+}
+
+static int extract_strategy(Solver_Context *ctx, Book *expanded, Position *pp) {
+	Evaluated_Move em_array[8 * N];
+	int n = get_moves(pp, em_array, ctx->engine->mode);
+	int flag;
+	Move move;
+	if (game_over(pp, n, &flag, ctx->engine->mode) || (pp->turn == ctx->attacker && book_move(ctx->engine, pp, &move))) return 1;
+	if (pp->turn != ctx->attacker) { // The defender's positions are expanded once, whichever line reaches them
+		int sign;
+		Compressed_Position key = canonical_position(pp, &sign);
+		if (expanded->count != 0 && book_find(expanded, &key)->used) return 1;
+		book_insert(expanded, &key, &em_array[0].move); // Only the key matters
+	}
+	Position children[8 * N];
+	int outcomes[8 * N];
+	for (int i = 0; i < n; i++) { // Results already in the table, which are used before any child is solved again
+		make_move(pp, children + i, &em_array[i].move);
+		normalize_position(children + i, ctx->engine->mode);
+		Compressed_Position key = solver_key(children + i, ctx->attacker);
+		uint32_t phi, delta;
+		outcomes[i] = (!solver_repetition(ctx, children + i) && proof_lookup(ctx->engine, &key, &phi, &delta)) ? solver_outcome(ctx, children + i, phi, delta) : 0;
+	}
+	int complete = 1;
+	ctx->path[ctx->path_length++] = compress_position(pp);
+	int chosen = -1;
+	if (pp->turn == ctx->attacker) {
+		for (int i = 0; i < n && chosen == -1; i++) {
+			if (outcomes[i] == 1) chosen = i;
+		}
+		for (int i = 0; i < n && chosen == -1 && complete; i++) { // Evicted from the table (or never stored), so solved again
+			if (outcomes[i] != 0 || solver_repetition(ctx, children + i)) continue;
+			if (solver_resolve(ctx, children + i) == 1) chosen = i;
+			else complete = !(ctx->limit != 0 && ctx->positions_visited >= ctx->limit) && !ctx->engine->stop;
+		}
+		if (chosen != -1) {
+			book_add(ctx->engine, pp, &em_array[chosen].move);
+			complete = extract_strategy(ctx, expanded, children + chosen);
+		}
+		else complete = 0;
+	}
+	else {
+		for (int i = 0; i < n && complete; i++) { // Every reply must be answered
+			if (solver_repetition(ctx, children + i)) continue;
+			if (outcomes[i] == 0) outcomes[i] = solver_resolve(ctx, children + i);
+			complete = (outcomes[i] == 1) && extract_strategy(ctx, expanded, children + i); // Unresolved if the budget ran out
+		}
+	}
+	ctx->path_length--;
+	return complete;
+}
+
+static int solver_resolve(Solver_Context *ctx, Position *pp) {
+	Compressed_Position key = solver_key(pp, ctx->attacker);
+	uint32_t phi, delta;
+	solver_mid(ctx, pp, &key, SOLVER_INFINITY, SOLVER_INFINITY, &phi, &delta);
+	return solver_outcome(ctx, pp, phi, delta);
+}
+
+static int open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed) {
+	int fd = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	struct stat st;
+	if (fd == -1 || fstat(fd, &st) == -1) return TABLE_OPEN_ERROR;
+	Table_Header header = {SOLVER_MAGIC, FILE_VERSION, engine->mode, N, 0};
+	*resumed = (st.st_size != 0);
+	if (*resumed) { // Resume from an earlier run, keeping that run's table size
+		Table_Header existing;
+		if (read(fd, &existing, sizeof(existing)) != sizeof(existing) || existing.magic != header.magic || existing.version != header.version ||
+			existing.mode != header.mode || existing.board_size != header.board_size || st.st_size != sizeof(Table_Header) + existing.entries * sizeof(Proof_Entry)) {
+			close(fd);
+			return TABLE_MISMATCH;
+		}
+		header.entries = existing.entries;
+	}
+	else {
+		header.entries = (uint64_t)megabytes * 1024 * 1024 / sizeof(Proof_Entry) / SOLVER_BUCKET * SOLVER_BUCKET;
+		if (ftruncate(fd, sizeof(Table_Header) + header.entries * sizeof(Proof_Entry)) == -1 || pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+			close(fd);
+			return TABLE_CREATE_ERROR;
+		}
+	}
+	// The table lives in the file, so the operating system may page it out when memory runs short, and the work done
+	// survives the process
+	size_t bytes = sizeof(Table_Header) + header.entries * sizeof(Proof_Entry);
+	void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return TABLE_MAP_ERROR;
+	engine->proof_table_map = map;
+	engine->proof_table_bytes = bytes;
+	engine->proof_table = (Proof_Entry *)((char *)map + sizeof(Table_Header));
+	engine->proof_table_size = header.entries;
+	for (int i = 0; i < SOLVER_LOCKS; i++) pthread_mutex_init(engine->proof_locks + i, NULL);
+	return TABLE_OK;
+}
+
+static void close_proof_table(Knights_Engine *engine) {
+	if (engine->proof_table_map == NULL) return;
+	msync(engine->proof_table_map, engine->proof_table_bytes, MS_SYNC);
+	munmap(engine->proof_table_map, engine->proof_table_bytes);
+	for (int i = 0; i < SOLVER_LOCKS; i++) pthread_mutex_destroy(engine->proof_locks + i);
+	engine->proof_table_map = NULL;
+}
+
+static Book_Entry *book_find(Book *book, Compressed_Position *key) {
+	uint64_t i = table_hash(key) & (book->capacity - 1);
+	while (book->entries[i].used && !equal_cmp(&book->entries[i].key, key)) i = (i + 1) & (book->capacity - 1);
+	return book->entries + i;
+}
+
+static void book_insert(Book *book, Compressed_Position *key, Move *move) {
+	if (2 * (book->count + 1) > book->capacity) { // Keep the table at most half full
+		Book_Entry *old_entries = book->entries;
+		uint64_t old_capacity = book->capacity;
+		book->capacity = (old_capacity == 0) ? 1024 : 2 * old_capacity;
+		book->entries = calloc(book->capacity, sizeof(Book_Entry));
+		for (uint64_t i = 0; i < old_capacity; i++) {
+			if (old_entries[i].used) *book_find(book, &old_entries[i].key) = old_entries[i];
+		}
+		free(old_entries);
+	}
+	Book_Entry *entry = book_find(book, key);
+	if (!entry->used) book->count++;
+	*entry = (Book_Entry){*key, *move, 1};
+}
+
+static void book_add(Knights_Engine *engine, Position *pp, Move *move) {
+	int sign;
+	Position position = *pp;
+	normalize_position(&position, engine->mode);
+	Compressed_Position key = canonical_position(&position, &sign);
+	Move stored_move = (sign == 1) ? *move : rotate_move(move); // Moves are stored as they would be played in the canonical position
+	book_insert(&engine->book, &key, &stored_move);
+}
+
+static int book_move(Knights_Engine *engine, Position *pp, Move *move) {
+	if (engine->book.count == 0) return 0;
+	int sign;
+	Position position = *pp;
+	normalize_position(&position, engine->mode);
+	Compressed_Position key = canonical_position(&position, &sign);
+	Book_Entry *entry = book_find(&engine->book, &key);
+	if (!entry->used) return 0;
+	*move = (sign == 1) ? entry->move : rotate_move(&entry->move);
+	return 1;
+}
+
+static int write_book(Knights_Engine *engine, const char *path) {
+	Book *book = &engine->book;
+	FILE *file = fopen(path, "wb");
+	Table_Header header = {BOOK_MAGIC, BOOK_VERSION, engine->mode, N, book->count};
+	if (file == NULL || fwrite(&header, sizeof(header), 1, file) != 1) {
+		if (file != NULL) fclose(file);
+		return 0;
+	}
+	for (uint64_t i = 0; i < book->capacity; i++) {
+		if (book->entries[i].used) {
+			Book_Record record;
+			memset(&record, 0, sizeof(record)); // So that padding is written as zeros
+			record.key = book->entries[i].key;
+			record.move = book->entries[i].move;
+			fwrite(&record, sizeof(record), 1, file);
+		}
+	}
+	fclose(file);
+	return 1;
+}
+
+static int read_book(Knights_Engine *engine, const char *path) {
+	FILE *file = fopen(path, "rb");
+	Table_Header header;
+	if (file == NULL || fread(&header, sizeof(header), 1, file) != 1 || header.magic != BOOK_MAGIC || header.version != BOOK_VERSION || header.mode != engine->mode || header.board_size != N) {
+		if (file != NULL) fclose(file);
+		return 0;
+	}
+	Book_Record record;
+	for (uint64_t i = 0; i < header.entries && fread(&record, sizeof(record), 1, file) == 1; i++) book_insert(&engine->book, &record.key, &record.move);
+	fclose(file);
+	return 1;
+}
+
+static long save_hash(Knights_Engine *engine, const char *path, int min_depth) {
+	char temporary[strlen(path) + 5];
+	snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+	FILE *file = fopen(temporary, "wb");
+	Table_Header header = {HASH_MAGIC, FILE_VERSION, engine->mode, N, 0};
+	if (file == NULL || fwrite(&header, sizeof(header), 1, file) != 1) {
+		if (file != NULL) fclose(file);
+		return -1;
+	}
+	for (int i = 0; i < engine->hash_table_size; i++) {
+		Evaluated_Position *entry = engine->hash_table + i;
+		if (entry->evaluation == IN_PROGRESS || entry->depth < min_depth || (entry->compressed_position.white_pieces == 0 && entry->compressed_position.black_pieces == 0)) continue;
+		Evaluated_Position record;
+		memset(&record, 0, sizeof(record)); // So that padding is written as zeros
+		record.compressed_position = entry->compressed_position;
+		record.evaluation = entry->evaluation;
+		record.depth = entry->depth;
+		if (fwrite(&record, sizeof(record), 1, file) != 1) break;
+		header.entries++;
+	}
+	// The number of entries is only known at the end
+	int written = !ferror(file) && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	if (fclose(file) != 0 || !written || rename(temporary, path) != 0) {
+		remove(temporary);
+		return -1;
+	}
+	return (long)header.entries;
+}
+
+static int load_hash(Knights_Engine *engine, const char *path, long *loaded) {
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	*loaded = 0;
+	if (fd == -1 || fstat(fd, &st) == -1) {
+		if (fd != -1) close(fd);
+		return TABLE_OPEN_ERROR;
+	}
+	if (st.st_size < (off_t)sizeof(Table_Header)) {
+		close(fd);
+		return TABLE_MISMATCH;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return TABLE_MAP_ERROR;
+	Table_Header *header = map;
+	if (header->magic != HASH_MAGIC || header->version != FILE_VERSION || header->mode != engine->mode || header->board_size != N ||
+		st.st_size != sizeof(Table_Header) + header->entries * sizeof(Evaluated_Position)) {
+		munmap(map, st.st_size);
+		return TABLE_MISMATCH;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	Evaluated_Position *records = (Evaluated_Position *)(header + 1);
+	for (uint64_t i = 0; i < header->entries; i++) {
+		Compressed_Position key = records[i].compressed_position;
+		int index;
+		// Reserves a slot unless the position is already there, as deeply evaluated, or the table has no room
+		if (check_hash(engine, &key, records[i].depth, &index) != NOT_IN_HASH) continue;
+		add_to_hash(engine, &key, records[i].evaluation, records[i].depth, index);
+		(*loaded)++;
+	}
+	munmap(map, st.st_size);
+	return TABLE_OK;
+}
+
+static void start_game(Knights_Engine *engine, Position *pp) {
+	engine->position = *pp;
+	engine->position_history[0] = compress_position(pp);
+	engine->move_number = 1;
+}
+
+static int read_list(const char *path, int *values, int max) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return 0;
+	int count = 0, first, last;
+	char separator = ',';
+	while (separator == ',' && fscanf(file, "%d", &first) == 1) {
+		last = first;
+		if (fscanf(file, "%c", &separator) == 1 && separator == '-' && (fscanf(file, "%d", &last) != 1 || fscanf(file, "%c", &separator) != 1)) separator = '\n';
+		for (int value = first; value <= last && count < max; value++) values[count++] = value;
+	}
+	fclose(file);
+	return count;
+}
+
+static int numa_nodes(unsigned long *mask) {
+	int nodes[MAX_NODES];
+	int count = read_list("/sys/devices/system/node/online", nodes, MAX_NODES);
+	int used = 0;
+	for (int i = 0; i < count; i++) {
+		if (nodes[i] >= MAX_NODES) continue;
+		mask[nodes[i] / (8 * sizeof(unsigned long))] |= 1UL << (nodes[i] % (8 * sizeof(unsigned long)));
+		used++;
+	}
+	return used;
+}
+
+static int find_processors(Knights_Engine *engine) {
+	cpu_set_t allowed;
+	unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+	int *listed = malloc(CPU_SETSIZE * sizeof(int));
+	int start[MAX_NODES + 1] = {0}; // The processors of the ith node are "listed[start[i]]" to "listed[start[i+1] - 1]"
+	engine->processors = malloc(CPU_SETSIZE * sizeof(int));
+	engine->processor_count = 0;
+	if (listed == NULL || engine->processors == NULL) {
+		free(listed);
+		return 0;
+	}
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+		CPU_ZERO(&allowed);
+		for (int i = 0; i < sysconf(_SC_NPROCESSORS_ONLN) && i < CPU_SETSIZE; i++) CPU_SET(i, &allowed);
+	}
+	int nodes = numa_nodes(mask), node_count = 0, total = 0;
+	for (int node = 0; node < MAX_NODES && nodes > 0; node++) {
+		if (!(mask[node / (8 * sizeof(unsigned long))] & (1UL << (node % (8 * sizeof(unsigned long)))))) continue;
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+		int count = read_list(path, listed + total, CPU_SETSIZE - total);
+		int kept = 0;
+		for (int i = 0; i < count; i++) { // Keep only the processors the engine may run on
+			int processor = listed[total + i];
+			if (processor < CPU_SETSIZE && CPU_ISSET(processor, &allowed)) listed[total + kept++] = processor;
+		}
+		if (kept > 0) {
+			start[node_count++] = total;
+			total += kept;
+		}
+	}
+	if (node_count == 0) { // No NUMA information, so treat the machine as a single node
+		for (int i = 0; i < CPU_SETSIZE; i++) {
+			if (CPU_ISSET(i, &allowed)) listed[total++] = i;
+		}
+		start[node_count++] = 0;
+	}
+	start[node_count] = total;
+	for (int round = 0; engine->processor_count < total; round++) {
+		for (int node = 0; node < node_count; node++) {
+			if (start[node] + round < start[node + 1]) engine->processors[engine->processor_count++] = listed[start[node] + round];
+		}
+	}
+	free(listed);
+	return 1;
+}
+
+static void *clear_table_part(void *table_part) {
+	Table_Part part = *((Table_Part *)table_part);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(part.processor, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	// The operating system places each page on the node of the processor which first writes to it
+	memset(part.engine->hash_table + part.start, 0, (part.end - part.start) * sizeof(Evaluated_Position));
+	for (int i = part.start; i < part.end; i++) pthread_mutex_init(part.engine->mutex_table + i, NULL);
+	return NULL;
+}
+
+static int allocate_hash_table(Knights_Engine *engine, Knights_Placement placement) {
+	size_t table_bytes = engine->hash_table_size * sizeof(Evaluated_Position);
+	size_t mutex_bytes = engine->hash_table_size * sizeof(pthread_mutex_t);
+	// Mapped memory, rather than "calloc", so that no page is touched before it has been placed
+	void *table = mmap(NULL, table_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	void *mutexes = mmap(NULL, mutex_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (table == MAP_FAILED || mutexes == MAP_FAILED) {
+		if (table != MAP_FAILED) munmap(table, table_bytes);
+		if (mutexes != MAP_FAILED) munmap(mutexes, mutex_bytes);
+		return 0;
+	}
+	engine->hash_table = table;
+	engine->mutex_table = mutexes;
+	unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+	int nodes = numa_nodes(mask);
+#ifdef SYS_mbind
+	if (placement == KNIGHTS_PLACEMENT_INTERLEAVE && nodes > 1) { // If the call fails, the pages are placed as usual
+		syscall(SYS_mbind, table, table_bytes, INTERLEAVE_POLICY, mask, MAX_NODES + 1, 0);
+		syscall(SYS_mbind, mutexes, mutex_bytes, INTERLEAVE_POLICY, mask, MAX_NODES + 1, 0);
+	}
+#endif
+	int count = engine->processor_count;
+	if (placement != KNIGHTS_PLACEMENT_FIRST_TOUCH || nodes < 2 || count < 2) {
+		for (int i = 0; i < engine->hash_table_size; i++) pthread_mutex_init(engine->mutex_table + i, NULL);
+		return 1;
+	}
+	Table_Part *parts = malloc(count * sizeof(Table_Part));
+	pthread_t *tid = malloc(count * sizeof(pthread_t));
+	int created = 0;
+	for (int i = 0; i < count && parts != NULL && tid != NULL; i++) {
+		parts[i] = (Table_Part){engine, engine->processors[i], (int)((long)engine->hash_table_size * i / count), (int)((long)engine->hash_table_size * (i + 1) / count)};
+		if (pthread_create(tid + i, NULL, clear_table_part, (void *)(parts + i)) != 0) break;
+		created++;
+	}
+	for (int i = 0; i < created; i++) pthread_join(tid[i], NULL);
+	int cleared = (created > 0) ? (int)((long)engine->hash_table_size * created / count) : 0;
+	for (int i = cleared; i < engine->hash_table_size; i++) pthread_mutex_init(engine->mutex_table + i, NULL); // Parts no thread was created for
+	free(parts);
+	free(tid);
+	return 1;
+}
+
+static void free_hash_table(Knights_Engine *engine) {
+	if (engine->hash_table == NULL) return;
+	for (int i = 0; i < engine->hash_table_size; i++) pthread_mutex_destroy(engine->mutex_table + i);
+	munmap(engine->hash_table, engine->hash_table_size * sizeof(Evaluated_Position));
+	munmap(engine->mutex_table, engine->hash_table_size * sizeof(pthread_mutex_t));
+}
+
+static Knights_Engine *board_create(const Knights_Options *options) {
+	Knights_Options defaults = {KNIGHTS_THREE_CHECKS, 0, 0, 0, KNIGHTS_PLACEMENT_DEFAULT, NULL, 0, N};
+	if (options == NULL) options = &defaults;
+	Knights_Engine *engine = calloc(1, sizeof(Knights_Engine));
+	if (engine == NULL) return NULL;
+	engine->board = &SIZED(knights_board, N);
+	engine->mode = (Mode)options->variant;
+	engine->number_of_threads = (options->threads > 0) ? options->threads : DEFAULT_THREADS;
+	engine->hash_table_size = (options->hash_table_size > 0) ? options->hash_table_size : DEFAULT_HASH_TABLE_SIZE;
+	engine->pin_threads = options->pin_threads;
+	engine->slot_taken = calloc(engine->number_of_threads, sizeof(char));
+	engine->pinned = malloc(engine->number_of_threads * sizeof(int));
+	engine->search_contexts = aligned_alloc(CACHE_LINE, 8 * N * sizeof(Search_Context));
+	if (engine->slot_taken == NULL || engine->pinned == NULL || engine->search_contexts == NULL || !find_processors(engine) || !allocate_hash_table(engine, options->placement)) {
+		free(engine->slot_taken);
+		free(engine->pinned);
+		free(engine->search_contexts);
+		free(engine->processors);
+		free(engine);
+		return NULL;
+	}
+	for (int i = 0; i < engine->number_of_threads; i++) engine->pinned[i] = -1;
+	for (int i = 0; i < 8 * N; i++) {
+		engine->search_contexts[i].engine = engine;
+		engine->search_contexts[i].clock_countdown = CLOCK_INTERVAL;
+	}
+	engine->host_threads = (options->host_threads > 0) ? options->host_threads : engine->processor_count;
+	if (options->host_budget != NULL) open_host_budget(engine, options->host_budget);
+	pthread_mutex_init(&engine->thread_lock, NULL);
+	pthread_cond_init(&engine->thread_finished, NULL);
+	board_new_game(engine);
+	return engine;
+}
+
+static void board_destroy(Knights_Engine *engine) {
+	if (engine == NULL) return;
+	close_proof_table(engine);
+	close_host_budget(engine);
+	free_hash_table(engine);
+	pthread_mutex_destroy(&engine->thread_lock);
+	pthread_cond_destroy(&engine->thread_finished);
+	free(engine->slot_taken);
+	free(engine->pinned);
+	free(engine->processors);
+	free(engine->search_contexts);
+	free(engine->book.entries);
+	free(engine);
+}
+
+static void board_new_game(Knights_Engine *engine) {
+	Position position;
+	memset(&position, 0, sizeof(position));
+	get_starting_position(&position);
+	start_game(engine, &position);
+}
+
+static int board_set_position(Knights_Engine *engine, uint64_t white_pieces, uint64_t black_pieces, unsigned checks_and_turn) {
+	Compressed_Position cmp = {(Packed_Pieces)white_pieces, (Packed_Pieces)black_pieces, (uint8_t)checks_and_turn};
+	if (cmp.white_pieces != white_pieces || cmp.black_pieces != black_pieces || checks_and_turn >= (1 << 5)) return 0;
+	Position position = decompress_position(&cmp);
+	if (!valid_position(&position)) return 0;
+	start_game(engine, &position);
+	return 1;
+}
+
+static int board_play(Knights_Engine *engine, Knights_Move move) {
+	Evaluated_Move em_array[8 * N];
+	int flag;
+	if (game_result(engine, &flag)) return 0;
+	if (move.start_row < 0 || move.start_row >= N || move.start_col < 0 || move.start_col >= N || move.end_row < 0 || move.end_row >= N || move.end_col < 0 || move.end_col >= N) return 0;
+	Move played = import_move(&move);
+	int n = get_moves(&engine->position, em_array, engine->mode);
+	for (int i = 0; i < n; i++) {
+		if ((em_array[i].move & MOVE_SQUARES_MASK) == played) {
+			play_move(engine, &em_array[i].move);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static Knights_Status board_status(Knights_Engine *engine) {
+	int flag;
+	if (!game_result(engine, &flag)) return KNIGHTS_ONGOING;
+	return (flag == WHITE_WINS) ? KNIGHTS_WHITE_WINS : (flag == BLACK_WINS) ? KNIGHTS_BLACK_WINS : KNIGHTS_DRAW;
+}
+
+static int board_search(Knights_Engine *engine, const Knights_Limits *limits, Knights_Progress progress, void *data, Knights_Result *result) {
+	int flag;
+	memset(result, 0, sizeof(Knights_Result));
+	if (game_result(engine, &flag)) return 0;
+	int depth = (limits->depth < 1) ? 1 : (limits->depth > KNIGHTS_MAX_DEPTH) ? KNIGHTS_MAX_DEPTH : limits->depth;
+	int multi_pv = (limits->multi_pv > 0) ? limits->multi_pv : 0;
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (limits->seconds > 0) {
+		long nanoseconds = start.tv_nsec + (long)((limits->seconds - (long)limits->seconds) * 1e9);
+		engine->deadline.tv_sec = start.tv_sec + (long)limits->seconds + nanoseconds / 1000000000;
+		engine->deadline.tv_nsec = nanoseconds % 1000000000;
+	}
+	engine->check_deadline = 0; // The first depth is searched without a time limit, so that a move is always found
+	engine->stop = 0;
+	engine->positions_evaluated = 0;
+	int found = 0;
+	double elapsed = 0, previous = 0; // Time elapsed, and time taken by the depth before the last
+	for (int d = (limits->seconds > 0) ? 1 : depth; d <= depth; d++) {
+		if (!search_position(engine, &engine->position, d, multi_pv, result)) break;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		result->depth = d;
+		result->positions = engine->positions_evaluated;
+		result->seconds = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+		found = 1;
+		if (progress != NULL) progress(result, data);
+		engine->check_deadline = (limits->seconds > 0);
+		double taken = result->seconds - elapsed;
+		elapsed = result->seconds;
+		// A loaded host takes longer over each depth, and so fits fewer in the time allowed.  The next depth is assumed
+		// to take as many times longer than the last as the last did than the one before; if it would overrun, it is
+		// not begun, since it would only be abandoned.
+		double growth = (previous > 0 && taken > previous) ? taken / previous : 1;
+		if (limits->seconds > 0 && elapsed + taken * growth > limits->seconds) break;
+		previous = taken;
+	}
+	return found;
+}
+
+static void board_stop(Knights_Engine *engine) {
+	engine->stop = 1;
+}
+
+static long board_save_table(Knights_Engine *engine, const char *path, int min_depth) {
+	return save_hash(engine, path, min_depth);
+}
+
+static int board_load_table(Knights_Engine *engine, const char *path, long *loaded) {
+	return load_hash(engine, path, loaded);
+}
+
+static void board_clear_table(Knights_Engine *engine) {
+	memset(engine->hash_table, 0, sizeof(Evaluated_Position) * engine->hash_table_size);
+}
+
+static int board_threads(Knights_Engine *engine) {
+	return engine->number_of_threads;
+}
+
+static int board_processors(Knights_Engine *engine) {
+	return engine->processor_count;
+}
+
+static void board_position(Knights_Engine *engine, Knights_Position *position) {
+	Position *pp = &engine->position;
+	Compressed_Position cmp = compress_position(pp);
+	memset(position, 0, sizeof(Knights_Position));
+	position->white_pieces = cmp.white_pieces;
+	position->black_pieces = cmp.black_pieces;
+	position->checks_and_turn = cmp.checks_and_turn;
+	position->squares[pp->kings[WHITE].row][pp->kings[WHITE].col] = KNIGHTS_WHITE_KING;
+	position->squares[pp->kings[BLACK].row][pp->kings[BLACK].col] = KNIGHTS_BLACK_KING;
+	for (int i = 0; i < pp->number_of_knights[WHITE]; i++) position->squares[pp->knights[WHITE][i].row][pp->knights[WHITE][i].col] = KNIGHTS_WHITE_KNIGHT;
+	for (int i = 0; i < pp->number_of_knights[BLACK]; i++) position->squares[pp->knights[BLACK][i].row][pp->knights[BLACK][i].col] = KNIGHTS_BLACK_KNIGHT;
+	position->turn = pp->turn;
+	position->in_check = pp->in_check;
+}
+
+static int board_open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed) {
+	close_proof_table(engine);
+	return open_proof_table(engine, path, megabytes, resumed);
+}
+
+static Knights_Status board_solve(Knights_Engine *engine, long limit, long *positions) {
+	if (engine->proof_table_map == NULL) return KNIGHTS_ONGOING;
+	Position position = engine->position;
+	normalize_position(&position, engine->mode);
+	engine->stop = 0;
+	// Whether the side to move wins, and failing that, whether the other side does; otherwise the game is drawn
+	long visited = 0;
+	int winner = position.turn;
+	int outcome = solve_for(engine, &position, winner, limit, &visited);
+	if (outcome == -1) {
+		long remaining = limit ? limit - visited : 0; // The limit is for both proofs together
+		winner = 1 - position.turn;
+		outcome = (limit && remaining <= 0) ? 0 : solve_for(engine, &position, winner, remaining, &visited);
+	}
+	*positions += visited;
+	if (outcome == 0) return KNIGHTS_ONGOING;
+	if (outcome == -1) return KNIGHTS_DRAW;
+	return (winner == WHITE) ? KNIGHTS_WHITE_WINS : KNIGHTS_BLACK_WINS;
+}
+
+static int board_build_book(Knights_Engine *engine, Knights_Status result, long limit, long *positions) {
+	if (engine->proof_table_map == NULL || (result != KNIGHTS_WHITE_WINS && result != KNIGHTS_BLACK_WINS)) return 0;
+	Position position = engine->position;
+	normalize_position(&position, engine->mode);
+	Solver_Context ctx = {engine, (result == KNIGHTS_WHITE_WINS) ? WHITE : BLACK, 0, limit, 0};
+	Book expanded = {NULL, 0, 0};
+	engine->stop = 0;
+	engine->solver_stop = 0;
+	int complete = extract_strategy(&ctx, &expanded, &position);
+	free(expanded.entries);
+	*positions += ctx.positions_visited;
+	return complete;
+}
+
+static long board_write_book(Knights_Engine *engine, const char *path) {
+	return write_book(engine, path) ? (long)engine->book.count : -1;
+}
+
+static int board_read_book(Knights_Engine *engine, const char *path) {
+	return read_book(engine, path);
+}
+
+static int board_book_move(Knights_Engine *engine, Knights_Move *move) {
+	Move book;
+	if (!book_move(engine, &engine->position, &book)) return 0;
+	*move = export_move(&book);
+	return 1;
+}
+
+const Knights_Board SIZED(knights_board, N) = {
+	N, board_create, board_destroy, board_threads, board_processors, board_new_game, board_set_position, board_play,
+	board_status, board_position, board_search, board_stop, board_save_table, board_load_table, board_clear_table,
+	board_open_proof_table, board_solve, board_build_book, board_write_book, board_read_book, board_book_move
+};
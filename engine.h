@@ -0,0 +1,470 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+// Types and functions of the engine library ("engine.c").  The functions are static, so that programs linking the
+// library (the command-line interface, "search.c", among them) see only those of "knights_engine.h".
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+#include "knights_engine.h"
+#include "boards.h"
+
+#define abs(x) ((x) < 0 ? -(x) : (x))
+#ifndef N
+#define N KNIGHTS_DEFAULT_BOARD_SIZE // Board size; each build of the engine is for the size given (e.g., "-DN=5")
+#endif
+#if N < KNIGHTS_MIN_BOARD_SIZE || N > KNIGHTS_MAX_BOARD_SIZE
+#error "Board size must be between 4 and 8"
+#endif
+#define K (N-2)
+#if N * N < 32 // A square is stored as its index plus one (see "compress_position"), so N * N + 1 values are needed
+#define SQUARE_BITS 5
+#elif N * N < 64
+#define SQUARE_BITS 6
+#else
+#define SQUARE_BITS 7
+#endif
+#define SQUARE_MASK ((1 << SQUARE_BITS) - 1)
+#define WHITE 0
+#define BLACK 1
+#define HASH_DEPTH 5
+#define NOT_IN_HASH 200 // Must be larger than greatest possible evaluation
+#define IN_PROGRESS 201
+#define ALPHA_REJECT -121
+#define BETA_REJECT 121
+#define MAX_DEPTH 100
+#define HASH_FULL 202
+#define DRAW 0
+#define CAPTURE 1
+#define CHECK 1
+#define POSSIBLE_VALUES 4 // The number of possible values a move can have; used to determine the order in which moves are evaluated
+#define SHALLOW_SEARCH_DEPTH 5 // Depth of a shallow search
+#define SHALLOW_EXECUTION_DEPTH 8 // Least depth at which a shallow search is executed
+#define FORCED_WIN_BLACK -101
+#define FORCED_WIN_WHITE 101
+#define BLACK_WINS -120
+#define WHITE_WINS 120
+#define MAX_MOVES 100
+#define MAX_PLY 32 // Greater than the length of any line searched, including the shallow searches made along it
+#define CACHE_LINE 64
+#define THREAD_STACK_SIZE (1 << 20)
+#define CLOCK_INTERVAL 4096 // Number of positions a thread searches between looking at the clock, when the search has a time limit
+#define DEFAULT_HASH_TABLE_SIZE 1000000
+#define DEFAULT_THREADS 8
+#define MAX_NODES 64 // Greatest number of NUMA nodes used when placing the hash table
+#define INTERLEAVE_POLICY 3 // "MPOL_INTERLEAVE" of <linux/mempolicy.h>, for the "mbind" system call
+#define HOST_MAGIC 0x5448484b // Identifies the shared memory holding a host-wide thread budget
+#define HOST_SLOTS 256 // Greatest number of engines sharing a host-wide thread budget
+#define HOST_POLL 2000000 // Nanoseconds a thread waiting for the host-wide budget waits before looking again
+#define HOST_PROCESSORS 1024 // Greatest number of processors a host-wide budget hands out to pinned threads
+#define SOLVER_INFINITY 0x3fffffff // Proof and disproof numbers are capped at this value, which means "proven" or "disproven"
+#define SOLVER_SLACK 4 // A child is searched until its number exceeds its sibling's by a quarter (the "1 + epsilon" trick)
+#define SOLVER_BUCKET 4 // Number of consecutive entries in the proof table in which a position may be stored
+#define SOLVER_LOCKS 4096 // Buckets of the proof table share this many locks
+#define SOLVER_MAGIC 0x4e50544b // Identifies proof table files
+#define SOLVER_SPLIT_DEPTH 6 // Greatest number of moves below the root at which a thread without a move of its own helps
+#define SOLVER_CLAIMS 4096 // Greatest number of positions which threads may take up to help with during one solve
+#define BOOK_MAGIC 0x4b4f424b // Identifies book files
+#define HASH_MAGIC 0x5348544b // Identifies snapshots of the hash table
+#define FILE_VERSION 1
+#define BOOK_VERSION 2 // Books hold packed moves since version 2
+#define TABLE_OK KNIGHTS_TABLE_OK
+#define TABLE_OPEN_ERROR KNIGHTS_TABLE_OPEN_ERROR
+#define TABLE_MISMATCH KNIGHTS_TABLE_MISMATCH
+#define TABLE_CREATE_ERROR KNIGHTS_TABLE_CREATE_ERROR
+#define TABLE_MAP_ERROR KNIGHTS_TABLE_MAP_ERROR
+#define MOVE_SQUARE_BITS 6
+#define MOVE_SQUARE_MASK 0x3f
+#define MOVE_SQUARES_MASK 0xfff // Both squares of a move
+#define MOVE_VALUE_SHIFT 12
+#define MOVE_VALUE_MASK 0x3
+#define LEAF_BATCH_SIZE ((8 * N + 15) / 16 * 16) // Upper bound on number of moves, rounded up to a whole number of vectors
+
+typedef struct Coord {
+	int8_t row;
+	int8_t col;
+} Coord;
+
+typedef struct Position { // Describes a position; 0 = white, 1 = black
+	Coord knights[2][N-1];
+	Coord kings[2];
+	int8_t checks[2]; // Number of checks remaining
+	int8_t number_of_knights[2]; // Number of knights remaining
+	int8_t turn;
+	int8_t in_check;
+	Coord checking_square;
+} Position;
+
+typedef uint16_t Move;
+// The starting and ending squares of a move, numbered "N * row + col", take six bits each (see "pack_move"), and its
+// expected value (see "ev") the two above them; the top two bits are spare
+
+typedef struct Evaluated_Move { // Four bytes, so that a ply's moves share a few cache lines
+	Move move;
+	int16_t evaluation;
+} Evaluated_Move;
+
+#if (K+1) * SQUARE_BITS <= 32
+typedef uint32_t Packed_Pieces; // Squares of a side's knights and king, "SQUARE_BITS" bits apiece
+#else
+typedef uint64_t Packed_Pieces;
+#endif
+
+typedef struct Compressed_Position {
+	Packed_Pieces white_pieces;
+	Packed_Pieces black_pieces;
+	uint8_t checks_and_turn;
+} Compressed_Position;
+
+typedef struct Evaluated_Position {
+	Compressed_Position compressed_position;
+	int evaluation;
+	int8_t depth;
+} Evaluated_Position;
+
+typedef struct Leaf_Batch { // Features of the positions resulting from each move at a frontier node, one array per feature
+	_Alignas(32) int16_t knights[2][LEAF_BATCH_SIZE];
+	_Alignas(32) int16_t checks[2][LEAF_BATCH_SIZE];
+	_Alignas(32) int16_t king_rows[2][LEAF_BATCH_SIZE];
+	_Alignas(32) int16_t evaluations[LEAF_BATCH_SIZE];
+} Leaf_Batch;
+
+typedef struct Search_Context { // State belonging to a single search thread, allocated before the search begins
+	_Alignas(CACHE_LINE) long positions_evaluated; // Alone in its cache line, so that threads do not contend for it
+	_Alignas(CACHE_LINE) Evaluated_Move move_stack[MAX_PLY][8 * N]; // Candidate moves at each ply
+	Leaf_Batch leaf_batch;
+	Move pv[MAX_PLY][MAX_PLY]; // "pv[ply]" holds the principal variation found from the position at "ply"
+	int pv_length[MAX_PLY];
+	Knights_Engine *engine; // Engine to which the context belongs
+	int clock_countdown; // Positions left to search before looking at the clock
+} Search_Context;
+
+typedef struct PDP {
+	Position *pp;
+	int depth;
+	Evaluated_Move *ptr;
+	Search_Context *sc;
+	int alpha;
+	int beta;
+	int slot; // See "acquire_thread"
+} PDP;
+
+typedef struct Proof_Entry {
+	Compressed_Position key; // See "solver_key"
+	uint32_t phi; // Proof number if the side to move is the attacker, and disproof number otherwise
+	uint32_t delta; // Disproof number if the side to move is the attacker, and proof number otherwise
+	uint32_t work; // Number of positions visited in finding "phi" and "delta"; zero for empty entries
+} Proof_Entry;
+
+typedef struct Table_Header { // Begins proof table, book and hash table snapshot files
+	uint32_t magic;
+	uint32_t version;
+	int32_t mode;
+	int32_t board_size;
+	uint64_t entries;
+} Table_Header;
+
+typedef struct Solver_Context { // State belonging to a single solver thread
+	Knights_Engine *engine;
+	int attacker; // The side trying to prove a win
+	long positions_visited;
+	long limit; // Number of positions visited at which the thread gives up, or zero for no limit
+	int path_length;
+	Compressed_Position path[MAX_MOVES]; // Positions between the root and the current position, to detect repetitions
+} Solver_Context;
+
+typedef struct Solver_Work { // Shared by the threads solving a position (see "solve_for")
+	Position root;
+	int n; // Number of moves from the root
+	Position children[8 * N];
+	Compressed_Position keys[8 * N];
+	uint32_t child_phi[8 * N];
+	uint32_t child_delta[8 * N];
+	pthread_mutex_t lock; // Guards the fields below
+	int next; // Next move from the root to be given a thread
+	int solved; // Number of moves from the root whose threads have finished
+	int claim_count;
+	Compressed_Position claims[SOLVER_CLAIMS];
+	// Positions a thread has taken up, which no other thread takes up again (though one may help below them)
+} Solver_Work;
+
+typedef struct Solver_Args {
+	Solver_Context *ctx;
+	Solver_Work *work;
+	int slot;
+} Solver_Args;
+
+typedef struct Host_Slot { // Search threads running in one engine
+	int32_t pid; // Process of the engine, or zero if the slot is free
+	int32_t threads;
+} Host_Slot;
+
+typedef struct Host_Budget { // Shared by all engines on the host given the same "host_budget"
+	uint32_t magic;
+	Host_Slot slots[HOST_SLOTS];
+	int32_t processors[HOST_PROCESSORS]; // For each processor, the process of the pinned thread running on it, or zero
+} Host_Budget;
+
+typedef struct Table_Part { // Entries "start" to "end" - 1 of the hash table, to be cleared from "processor"
+	Knights_Engine *engine;
+	int processor;
+	int start;
+	int end;
+} Table_Part;
+
+typedef struct Book_Entry {
+	Compressed_Position key; // Canonical form of a position in which the winning side is to move
+	Move move; // The winning move, as it would be played in the canonical position
+	int used;
+} Book_Entry;
+
+typedef struct Book_Record { // Form in which book entries are written to a file
+	Compressed_Position key;
+	Move move;
+} Book_Record;
+
+typedef struct Book { // Open-addressed hash table of book entries
+	Book_Entry *entries;
+	uint64_t capacity; // Always a power of two
+	uint64_t count;
+} Book;
+
+typedef enum Mode {THREE_CHECKS, KINGS_CROSS} Mode; // Same values as "Knights_Variant"
+typedef enum Move_Type {KING_MOVE, KNIGHT_MOVE} Move_Type;
+
+struct Knights_Engine { // Everything a search needs, so that engines share nothing
+	const Knights_Board *board; // Functions of the build for this board size; first, so that "knights_engine.c" finds it
+	Mode mode;
+	int number_of_threads;
+	int threads_running;
+	pthread_mutex_t thread_lock;
+	pthread_cond_t thread_finished;
+	char *slot_taken; // For each of the "number_of_threads" slots, whether a running thread holds it
+	int *pinned; // For each slot, the processor its thread took from the host-wide budget, or -1
+	int pin_threads;
+	int *processors; // Processors the engine may run on, taking each NUMA node in turn
+	int processor_count;
+	Host_Budget *host; // NULL unless the engine shares a host-wide thread budget
+	Host_Slot *host_slot; // This engine's slot in "host"
+	int host_threads;
+	Evaluated_Position *hash_table;
+	pthread_mutex_t *mutex_table;
+	int hash_table_size;
+	Search_Context *search_contexts; // One for each move available at the root
+	long positions_evaluated;
+	volatile int stop; // Set to abandon the search in progress
+	int check_deadline; // Whether the search is abandoned at "deadline"
+	struct timespec deadline;
+	Position position; // Current position of the game being played
+	Compressed_Position position_history[MAX_MOVES];
+	int move_number; // Move number of the next move to be played
+	void *proof_table_map;
+	size_t proof_table_bytes;
+	Proof_Entry *proof_table;
+	uint64_t proof_table_size;
+	pthread_mutex_t proof_locks[SOLVER_LOCKS];
+	volatile int solver_stop; // Set once the result at the root is known, so that the other threads may stop
+	Book book;
+};
+
+static Knights_Engine *board_create(const Knights_Options *options);
+static void board_destroy(Knights_Engine *engine);
+static void board_new_game(Knights_Engine *engine);
+static int board_set_position(Knights_Engine *engine, uint64_t white_pieces, uint64_t black_pieces, unsigned checks_and_turn);
+static int board_play(Knights_Engine *engine, Knights_Move move);
+static Knights_Status board_status(Knights_Engine *engine);
+static int board_search(Knights_Engine *engine, const Knights_Limits *limits, Knights_Progress progress, void *data, Knights_Result *result);
+static void board_stop(Knights_Engine *engine);
+static int board_threads(Knights_Engine *engine);
+static int board_processors(Knights_Engine *engine);
+static void board_position(Knights_Engine *engine, Knights_Position *position);
+static long board_save_table(Knights_Engine *engine, const char *path, int min_depth);
+static int board_load_table(Knights_Engine *engine, const char *path, long *loaded);
+static void board_clear_table(Knights_Engine *engine);
+static int board_open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed);
+static Knights_Status board_solve(Knights_Engine *engine, long limit, long *positions);
+static int board_build_book(Knights_Engine *engine, Knights_Status result, long limit, long *positions);
+static long board_write_book(Knights_Engine *engine, const char *path);
+static int board_read_book(Knights_Engine *engine, const char *path);
+static int board_book_move(Knights_Engine *engine, Knights_Move *move);
+// The library's functions (see "knights_engine.h") for this board size, listed in its "Knights_Board"
+
+static int get_moves(Position *pp, Evaluated_Move *mp, Mode mode);
+// Adds moves to "mp" in decreasing order of expected value (and otherwise in the order generated) and returns number
+// of moves added
+static void make_move(Position *pp_old, Position *pp_new, Move *move); // Stores position which results from making given move in old position
+static void play_move(Knights_Engine *engine, Move *move); // Makes a move in the engine's current position, and records the resulting position
+static void get_starting_position(Position *pp);
+static void start_game(Knights_Engine *engine, Position *pp); // Begins a new game from "pp"
+
+static int shallow_reject(Search_Context *sc, Position *pp, int alpha, int beta, int16_t *flag, int *shallow_best, int ply);
+// Evaluates a move at a shallow depth to determine whether it's worth exploring more thoroughly
+static int find_best_move(Search_Context *sc, Position *pp, Move *mp, int alpha, int beta, int depth, int ply);
+static void *get_best_move_wrapper(void *position_depth_and_ptr);
+static void update_pv(Search_Context *sc, int ply, Move *move); // Sets the principal variation at "ply" to "move" followed by that at "ply + 1"
+// Examines position up to given depth and stores best move it finds in "mp".  Uses probabilistic cutting to
+// reduce search space, and so may produce sub-optimal moves.  Its wrapper serves as a suitable entry point
+// for newly created threads.  "ply" is the number of moves made since the root, and determines which part of the
+// search context's move stack is used.
+static int search_stopped(Search_Context *sc); // Whether the search should be abandoned; looks at the clock every "CLOCK_INTERVAL" positions
+
+static void search_moves(Knights_Engine *engine, Position *pp, Evaluated_Move *em_array, int *indices, int count, int alpha, int beta, int depth);
+// Searches the positions resulting from the moves "em_array[indices[0]]", ..., "em_array[indices[count-1]]" concurrently,
+// using the window (alpha, beta), and stores their evaluations in "em_array".  The search of "em_array[i]" uses the
+// search context "search_contexts[i]", so its principal variation may be found there.
+static int search_multi_pv(Knights_Engine *engine, Position *pp, Evaluated_Move *em_array, int *indices, int n, int depth, int multi_pv);
+// Finds the exact evaluations of the best "multi_pv" moves (and of any move which was, when searched, at least as good
+// as the "multi_pv"th best so far), and only bounds for the rest; moves whose evaluations are not exact are marked as
+// rejected.  Returns the number of moves evaluated exactly, whose indices are placed, best first, at the start of
+// "indices".
+static void sort_moves(Evaluated_Move *em_array, int *indices, int count, int turn); // Sorts indices, best move for "turn" first
+static int search_position(Knights_Engine *engine, Position *pp, int depth, int multi_pv, Knights_Result *result);
+// Searches every move from "pp" (finding exact evaluations for the best "multi_pv" moves only, if "multi_pv" is
+// positive) and fills in the moves and evaluations of "result".  Returns zero if the search was stopped.
+static int acquire_thread(Knights_Engine *engine);
+static void release_thread(Knights_Engine *engine, int slot);
+// Limit the number of threads running at once to "number_of_threads" (and, beyond the first, to what the host-wide
+// budget allows).  Each running thread holds a slot, numbered from zero, which decides the processor it is pinned to.
+static int host_busy(Knights_Engine *engine);
+// Whether the engines sharing the host-wide budget are running as many threads as it allows
+static void reclaim_host_slots(Knights_Engine *engine);
+// Frees the slots of processes which exited while running threads.  Since this asks the system about every such
+// process, it is only done when a thread finds the host busy (see "acquire_thread").  Whether a process is alive is
+// judged by "kill(pid, 0)", so engines in other PID namespaces (such as containers sharing the same "/dev/shm") are
+// misjudged: their pids mean nothing here, and their slots may be freed while they run, or kept after they exit.
+static int open_host_budget(Knights_Engine *engine, const char *name);
+static void close_host_budget(Knights_Engine *engine);
+// Join and leave a host-wide thread budget.  If it cannot be joined (the shared memory cannot be opened, or is in use
+// for something else, or every slot is taken), returns zero and the engine runs as if none had been given.
+static void pin_thread(Knights_Engine *engine, int slot);
+// If "pin_threads" is set, pins the calling thread to the processor of "slot", or, if the engine shares a host-wide
+// budget, to a processor which no other pinned thread on the host is running on (leaving it unpinned if there is none)
+static int take_processor(Knights_Engine *engine);
+// Takes a processor from the host-wide budget, one left by a process which has exited if none is free, and returns
+// it, or -1 if every processor the engine may run on is taken.  "release_thread" gives it back.
+static int find_processors(Knights_Engine *engine);
+// Lists the processors the engine may run on, one from each NUMA node in turn (so that pinned threads are spread
+// evenly across nodes).  Returns zero if memory could not be allocated.
+static int read_list(const char *path, int *values, int max);
+// Reads a list of numbers and ranges (such as "0-3,8"), as found in "/sys/devices/system", into "values", and returns
+// the number of values read (zero if the file could not be read)
+static int numa_nodes(unsigned long *mask); // Sets the bits of "mask" (of "MAX_NODES" bits) for the nodes online, and returns their number
+static int allocate_hash_table(Knights_Engine *engine, Knights_Placement placement);
+static void free_hash_table(Knights_Engine *engine);
+// Allocate the hash table and its mutexes, placed across NUMA nodes as "placement" requires, and free them
+static void *clear_table_part(void *table_part); // Entry point of the threads which clear a part of the hash table each
+
+static int equal_cmp(Compressed_Position *p1, Compressed_Position *p2); // Determines whether two positions are equal
+static int equal_crd(Coord *c1, Coord *c2); // Determines whether two coordinates are equal
+static void add_to_hash(Knights_Engine *engine, Compressed_Position *compressed_position, int evaluation, int depth, int index);
+static void release_hash(Knights_Engine *engine, int index); // Empties a slot reserved by "check_hash" whose position could not be evaluated exactly
+static int check_hash(Knights_Engine *engine, Compressed_Position *compressed_position, int depth, int *index);
+// Check if a position is in the hash table.  If so, return its evaluation; if not, and there is space,
+// add it to the table and set "*index" accordingly.
+
+static int find_max_index(Evaluated_Move array[], int length);
+static int find_min_index(Evaluated_Move array[], int length);
+// Return best moves from array (i.e., moves with greatest evaluation for White and smallest evaluation for Black)
+
+static Move pack_move(Coord *start, Coord *end, int value); // Packs a move from "start" to "end" with expected value "value"
+static Coord move_start(Move move);
+static Coord move_end(Move move);
+static int move_value(Move move);
+// Unpack the parts of a move
+
+static int evaluate_position(Position *pp, Mode mode); // Gives rudimentary (depth-0) evaluation of position
+static int evaluate_leaves(Search_Context *sc, Position *pp, Evaluated_Move *em_array, int n, Move *mp, int alpha, int beta);
+static void score_leaf_batch(Leaf_Batch *lb, int n, int *min, int *max, Mode mode);
+// Equivalent to a depth-1 search from "pp", whose "n" moves are in "em_array".  The features of all resulting positions
+// are gathered into a "Leaf_Batch" and scored at once (using SIMD instructions where available).
+static int ev(Position *pp, Coord *start, Coord *end, Move_Type move_type, Mode mode);
+// Returns an integer representing the promise of a candidate move (the greater the integer, the more promising the move)
+
+static int knight_attacks(Coord *knight_position, Coord *coord);
+static int king_attacks(Coord *king_position, Coord *coord);
+static int is_protected(Position *pp, Coord *coord);
+static int occupied_opponent(Position *pp, Coord *coord);
+// Helper functions to determine legal moves
+
+static void set_pieces(Packed_Pieces pieces, Position *pp, int color);
+static Position decompress_position(Compressed_Position *cmp);
+static Compressed_Position compress_position(Position *pp);
+// Allow for the compression (for use in hash table) and decompression (for all other uses) of "Position" structures
+static Packed_Pieces pack_pieces(Coord *knights, int number_of_knights, Coord *king, int rotate);
+// Packs the squares of one side's pieces, with knights in increasing order of square (so that the order in which
+// they are stored does not matter).  If "rotate" is set, the board is first rotated by 180 degrees.
+static Compressed_Position canonical_position(Position *pp, int *sign);
+// Both variants are unchanged by rotating the board 180 degrees and swapping the colours of all pieces (and the side
+// to move).  Returns the lesser of the compressed forms of the position and of its image under this symmetry, so
+// that both are stored under a single key.  "*sign" is set to -1 if the image was chosen (in which case evaluations
+// must be negated on their way to and from the hash table) and to 1 otherwise.
+static int valid_position(Position *pp); // Whether every piece of a decompressed position is on the board, on a square of its own
+static Knights_Move export_move(Move *move);
+static Move import_move(Knights_Move *move);
+// Convert between the engine's moves and those of the library's interface
+
+static int solve_for(Knights_Engine *engine, Position *pp, int attacker, long limit, long *positions_visited);
+static void *solver_wrapper(void *solver_args);
+// Return 1 if "attacker" wins from "pp" with best play and -1 if it does not, using depth-first proof-number search,
+// or 0 if the threads visit "limit" positions between them (unless it is zero) before the result is known.  The threads take
+// the moves from "pp" one at a time, each solving it alone, and all share the proof table.  Once every move has been
+// taken, a thread left without one helps with those still being solved (see "solver_find_work").  Since a win is never
+// obtained by repeating a position, a position repeated along the current line (or reached after "MAX_MOVES" moves)
+// counts as a draw.  If "stop" is set (see "board_stop"), the threads also stop and zero is returned.  The root is
+// then left unresolved in the proof table, which keeps the numbers found so far, so that the next run resumes.
+static int solver_find_work(Solver_Context *ctx, Solver_Work *work, Position *pp, int depth, Position *found, Compressed_Position *key);
+// Looks below "pp" (reached by the line in "ctx->path", "depth" moves from the root) for an unresolved position which
+// no thread has taken up, trying the first unresolved child, and then, if every child is taken, the positions below
+// them in turn ("splitting" them again), up to "SOLVER_SPLIT_DEPTH" moves from the root.  If one is found, it is taken
+// up and stored in "*found" and "*key", the line leading to it is left in "ctx->path", and one is returned.  The
+// thread solving the position above it finds the result in the proof table.
+static int solver_mid(Solver_Context *ctx, Position *pp, Compressed_Position *key, uint32_t th_phi, uint32_t th_delta, uint32_t *phi, uint32_t *delta);
+// Expands the tree below "pp" until its proof or disproof number reaches the corresponding threshold, and stores the
+// resulting numbers in "*phi" and "*delta" and in the proof table.  Returns whether the result depends on the line
+// leading to "pp" (because of a repetition), in which case it is not stored in the table, since it may not hold when
+// "pp" is reached by another line.  Near the root, children are looked up again before each is chosen, so that results
+// found by helping threads are used as soon as they are stored.
+static void solver_result(Solver_Context *ctx, Position *pp, int attacker_wins, uint32_t *phi, uint32_t *delta);
+static int solver_outcome(Solver_Context *ctx, Position *pp, uint32_t phi, uint32_t delta);
+// Convert between a result (1 if the attacker wins, -1 if it does not, 0 if unknown) and proof and disproof numbers
+static int solver_repetition(Solver_Context *ctx, Position *pp); // Whether "pp" must count as a draw because of the line leading to it
+static int extract_strategy(Solver_Context *ctx, Book *expanded, Position *pp);
+// Adds a winning move for every position the winner ("ctx->attacker") may face to the book.  Moves proven to win in
+// the proof table are preferred, so that a position is only solved again if none is found there (because its entry
+// was evicted, or its result depended on the line leading to it).  Each of the defender's positions is expanded only
+// once, and is then recorded in "expanded".  Returns zero if the book is incomplete, because solving again visited
+// "ctx->limit" positions, or "stop" was set.
+static int solver_resolve(Solver_Context *ctx, Position *pp); // Solves "pp" again, and returns its outcome (see "solver_outcome")
+static void normalize_position(Position *pp, Mode mode); // Resets fields which do not matter in the current variant
+static Move rotate_move(Move *move); // Image of a move under a 180 degree rotation of the board
+static Compressed_Position solver_key(Position *pp, int attacker);
+static uint64_t table_hash(Compressed_Position *key);
+static int open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed);
+static void close_proof_table(Knights_Engine *engine);
+// The proof table is stored in a memory-mapped file.  If the file already exists, the solver resumes the work in it
+// (and "*resumed" is set); otherwise a table of "megabytes" megabytes is created.  Returns "TABLE_OK" or the error.
+static int proof_lookup(Knights_Engine *engine, Compressed_Position *key, uint32_t *phi, uint32_t *delta);
+static void proof_store(Knights_Engine *engine, Compressed_Position *key, uint32_t phi, uint32_t delta, uint32_t work);
+static Book_Entry *book_find(Book *book, Compressed_Position *key); // Returns the entry for "key" or, if there is none, the empty slot where it belongs
+static void book_insert(Book *book, Compressed_Position *key, Move *move);
+static void book_add(Knights_Engine *engine, Position *pp, Move *move);
+static int book_move(Knights_Engine *engine, Position *pp, Move *move); // Finds the book move in "pp", if any
+static int write_book(Knights_Engine *engine, const char *path);
+static int read_book(Knights_Engine *engine, const char *path);
+static long save_hash(Knights_Engine *engine, const char *path, int min_depth);
+// Writes every position in the hash table evaluated to at least "min_depth" to a snapshot file, and returns their
+// number, or -1 on failure.  The file is written under a temporary name and then renamed, so that an interrupted save
+// leaves any earlier snapshot intact.
+static int load_hash(Knights_Engine *engine, const char *path, long *loaded);
+// Maps a snapshot file and adds its positions to the hash table (each in a slot chosen as by "check_hash"), counting
+// them in "*loaded".  Returns "TABLE_OK", "TABLE_OPEN_ERROR",
+// "TABLE_MISMATCH" (if it is for a different variant or board size, or damaged) or "TABLE_MAP_ERROR".  Must not be
+// called during a search.
+
+static int game_over(Position *pp, int available_moves, int *flag, Mode mode);
+static int game_result(Knights_Engine *engine, int *flag);
+// Whether the game being played has finished (including by repetition or by its length), with its result in "*flag"
+
+#endif
@@ -1,10 +1,18 @@
 var cp = require("child_process");
+var os = require("os");
 const express = require("../node_modules/express");
 const app = express();
 var http = require("http").Server(app);
 var io = require("../node_modules/socket.io")(http);
 var engines = new Map();
 var tot_engines = 0;
+// Engines share the host's processors through a common thread budget, and answer within (about) this many seconds,
+// searching less deeply as the host grows busier, so that games are never refused for want of processors.  The budget
+// does nothing for memory, though: each engine holds a hash table of "-h" positions, with a mutex apiece (about 60
+// bytes an entry), so the tables are kept small, and games are refused once they would take half the host's memory.
+var ENGINE_ARGS = ["-H", "/knights_engine", "-L", "2", "-h", "100000"];
+var ENGINE_BYTES = 8 * 1024 * 1024; // Hash table, search contexts and the rest, rounded up
+var MAX_ENGINES = Math.max(1, Math.floor(os.totalmem() / 2 / ENGINE_BYTES));
 
 app.use(express.static("."));
 
@@ -64,15 +72,15 @@ io.on('connection', function(socket) {
 	});
 	socket.on("new_game", function(game_type) {
 		if (engine != null) engine.kill("SIGINT");
-		if (engines.size > 10) {
+		else if (engines.size >= MAX_ENGINES) {
 			socket.emit("status", "Server busy; please try again later.");
 			return;
 		}
 		if (game_type == "three_checks") {
-			engine = cp.spawn("./a.out");
+			engine = cp.spawn("./a.out", ENGINE_ARGS);
 		}
 		else {
-			engine = cp.spawn("./a.out", ["-m "]);
+			engine = cp.spawn("./a.out", ENGINE_ARGS.concat(["-m"]));
 		}
 		engines.set(engine_num, engine);
 		engine.stdout.on("data", function(data_buf) {
@@ -0,0 +1,112 @@
+#include <stddef.h>
+#include <sys/mman.h>
+#include "boards.h"
+
+// The library's functions, each of which passes its arguments on to the build of the engine for the board size of
+// the engine given (or, when an engine is created, of the size asked for)
+
+static const Knights_Board *find_board(int size); // Returns NULL if no build is for "size"
+static const Knights_Board *board_of(Knights_Engine *engine);
+
+static const Knights_Board *boards[] = {&knights_board_4, &knights_board_5, &knights_board_6, &knights_board_7, &knights_board_8};
+
+static const Knights_Board *find_board(int size) {
+	if (size < KNIGHTS_MIN_BOARD_SIZE || size > KNIGHTS_MAX_BOARD_SIZE) return NULL;
+	return boards[size - KNIGHTS_MIN_BOARD_SIZE];
+}
+
+static const Knights_Board *board_of(Knights_Engine *engine) {
+	return *(const Knights_Board **)engine; // Every engine begins with its board (see "struct Knights_Engine")
+}
+
+Knights_Engine *knights_engine_create(const Knights_Options *options) {
+	int size = (options == NULL || options->board_size == 0) ? KNIGHTS_DEFAULT_BOARD_SIZE : options->board_size;
+	const Knights_Board *board = find_board(size);
+	if (board == NULL) return NULL;
+	return board->create(options);
+}
+
+void knights_engine_destroy(Knights_Engine *engine) {
+	if (engine == NULL) return;
+	board_of(engine)->destroy(engine);
+}
+
+int knights_engine_board_size(Knights_Engine *engine) {
+	return board_of(engine)->size;
+}
+
+int knights_engine_threads(Knights_Engine *engine) {
+	return board_of(engine)->threads(engine);
+}
+
+int knights_engine_processors(Knights_Engine *engine) {
+	return board_of(engine)->processors(engine);
+}
+
+int knights_engine_remove_host_budget(const char *name) {
+	return shm_unlink(name) == 0; // The budget is the same for every board size, so no build is needed
+}
+
+void knights_engine_new_game(Knights_Engine *engine) {
+	board_of(engine)->new_game(engine);
+}
+
+int knights_engine_set_position(Knights_Engine *engine, uint64_t white_pieces, uint64_t black_pieces, unsigned checks_and_turn) {
+	return board_of(engine)->set_position(engine, white_pieces, black_pieces, checks_and_turn);
+}
+
+int knights_engine_play(Knights_Engine *engine, Knights_Move move) {
+	return board_of(engine)->play(engine, move);
+}
+
+Knights_Status knights_engine_status(Knights_Engine *engine) {
+	return board_of(engine)->status(engine);
+}
+
+void knights_engine_position(Knights_Engine *engine, Knights_Position *position) {
+	board_of(engine)->position(engine, position);
+}
+
+int knights_engine_search(Knights_Engine *engine, const Knights_Limits *limits, Knights_Progress progress, void *data, Knights_Result *result) {
+	return board_of(engine)->search(engine, limits, progress, data, result);
+}
+
+void knights_engine_stop(Knights_Engine *engine) {
+	board_of(engine)->stop(engine);
+}
+
+long knights_engine_save_table(Knights_Engine *engine, const char *path, int min_depth) {
+	return board_of(engine)->save_table(engine, path, min_depth);
+}
+
+int knights_engine_load_table(Knights_Engine *engine, const char *path, long *loaded) {
+	return board_of(engine)->load_table(engine, path, loaded);
+}
+
+void knights_engine_clear_table(Knights_Engine *engine) {
+	board_of(engine)->clear_table(engine);
+}
+
+int knights_engine_open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed) {
+	return board_of(engine)->open_proof_table(engine, path, megabytes, resumed);
+}
+
+Knights_Status knights_engine_solve(Knights_Engine *engine, long limit, long *positions) {
+	return board_of(engine)->solve(engine, limit, positions);
+}
+
+int knights_engine_build_book(Knights_Engine *engine, Knights_Status result, long limit, long *positions) {
+	return board_of(engine)->build_book(engine, result, limit, positions);
+}
+
+long knights_engine_write_book(Knights_Engine *engine, const char *path) {
+	return board_of(engine)->write_book(engine, path);
+}
+
+int knights_engine_read_book(Knights_Engine *engine, const char *path) {
+	return board_of(engine)->read_book(engine, path);
+}
+
+int knights_engine_book_move(Knights_Engine *engine, Knights_Move *move) {
+	return board_of(engine)->book_move(engine, move);
+}
@@ -0,0 +1,169 @@
+#ifndef KNIGHTS_ENGINE_H
+#define KNIGHTS_ENGINE_H
+
+// Public interface of the engine library (libknightsengine).  Engines share no state, so any number of them may be
+// used at once, from different threads; a single engine must not be used by two threads at once, except that
+// "knights_engine_stop" may be called while it searches.  The library never prints or exits the process.
+
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define KNIGHTS_API __attribute__((visibility("default")))
+#else
+#define KNIGHTS_API
+#endif
+
+#define KNIGHTS_MAX_MOVES 64 // At least the number of moves available in any position, on any board
+#define KNIGHTS_MAX_LINE 32 // More than the length of any principal variation
+#define KNIGHTS_MAX_DEPTH 12
+#define KNIGHTS_MIN_BOARD_SIZE 4
+#define KNIGHTS_MAX_BOARD_SIZE 8
+#define KNIGHTS_DEFAULT_BOARD_SIZE 6
+#define KNIGHTS_WIN 120 // Evaluation of a win for White (see "Knights_Line")
+#define KNIGHTS_FORCED_WIN 101 // Least evaluation of a win White forces; the negations of both are Black's
+#define KNIGHTS_TABLE_OK 0 // Results of opening a file of the engine's (see "knights_engine_load_table")
+#define KNIGHTS_TABLE_OPEN_ERROR 1 // Including when the file does not exist
+#define KNIGHTS_TABLE_MISMATCH 2 // Written for a different variant or board size, or damaged
+#define KNIGHTS_TABLE_CREATE_ERROR 3
+#define KNIGHTS_TABLE_MAP_ERROR 4
+
+typedef struct Knights_Engine Knights_Engine;
+
+typedef enum Knights_Variant {KNIGHTS_THREE_CHECKS, KNIGHTS_KINGS_CROSS} Knights_Variant;
+typedef enum Knights_Status {KNIGHTS_ONGOING, KNIGHTS_WHITE_WINS, KNIGHTS_BLACK_WINS, KNIGHTS_DRAW} Knights_Status;
+typedef enum Knights_Placement { // Where the pages of the hash table are placed on a machine with several NUMA nodes
+	KNIGHTS_PLACEMENT_DEFAULT, // Wherever the operating system puts them (usually the node of the creating thread)
+	KNIGHTS_PLACEMENT_INTERLEAVE, // Spread evenly across all nodes
+	KNIGHTS_PLACEMENT_FIRST_TOUCH // Each part on the node of the processor which clears it, one thread per processor
+} Knights_Placement;
+
+typedef struct Knights_Options {
+	Knights_Variant variant;
+	int hash_table_size; // Number of positions the hash table holds (a prime spreads them more evenly); if zero, 1000000
+	int threads; // Greatest number of search threads running at once; if zero, 8
+	int pin_threads; // If nonzero, each search thread is pinned to a processor of its own, taken from each node in turn
+	// (with "host_budget", from those no other engine sharing it has pinned a thread to, or else left unpinned)
+	Knights_Placement placement; // Placements other than the default have no effect on a machine with a single node
+	const char *host_budget;
+	// If set, the name of a shared memory object (e.g., "/knights_engine") through which all engines on the host given
+	// the same name count their search threads, so that together they run at most "host_threads" of them (besides
+	// the first thread of each search, which never waits).  The object outlives the engines using it, until it is
+	// removed (see "knights_engine_remove_host_budget", or "rm /dev/shm/knights_engine" on Linux).
+	int host_threads; // If zero, the number of processors
+	int board_size; // From "KNIGHTS_MIN_BOARD_SIZE" to "KNIGHTS_MAX_BOARD_SIZE"; if zero, "KNIGHTS_DEFAULT_BOARD_SIZE"
+} Knights_Options;
+
+typedef enum Knights_Piece {KNIGHTS_EMPTY, KNIGHTS_WHITE_KING, KNIGHTS_WHITE_KNIGHT, KNIGHTS_BLACK_KING, KNIGHTS_BLACK_KNIGHT} Knights_Piece;
+
+typedef struct Knights_Move { // Rows are numbered from Black's side of the board, and columns from White's left, both from zero
+	int8_t start_row;
+	int8_t start_col;
+	int8_t end_row;
+	int8_t end_col;
+} Knights_Move;
+
+typedef struct Knights_Position { // The current position, as reported by "knights_engine_position"
+	uint64_t white_pieces; // Compressed form, as taken by "knights_engine_set_position"
+	uint64_t black_pieces;
+	unsigned checks_and_turn;
+	int8_t squares[KNIGHTS_MAX_BOARD_SIZE][KNIGHTS_MAX_BOARD_SIZE]; // The "Knights_Piece" on each square, numbered as in "Knights_Move"
+	int turn; // 0 if White is to move, 1 if Black is
+	int in_check; // Whether the side to move is in check
+} Knights_Position;
+
+typedef struct Knights_Limits {
+	int depth; // Depth of the search, between 1 and "KNIGHTS_MAX_DEPTH"
+	double seconds;
+	// If positive, the search deepens one ply at a time, and stops at "depth", when time runs out, or when the next
+	// depth is not expected to finish in time (judging by how long the last ones took, which reflects the load on the
+	// host), so that the search seldom takes much longer than "seconds"
+	int multi_pv; // If positive, only this many of the best moves are evaluated exactly
+} Knights_Limits;
+
+typedef struct Knights_Line { // A move from the searched position, with the line of play expected to follow it
+	Knights_Move move;
+	int evaluation; // Greater values favour White; 120 - n (for n < 20) means White forces a win in n moves, and n - 120 that Black does
+	int exact; // Whether "evaluation" is exact, or only shows that the move is worse than those ranked above it
+	int length;
+	Knights_Move line[KNIGHTS_MAX_LINE];
+} Knights_Line;
+
+typedef struct Knights_Result {
+	int depth; // Depth of the deepest completed search
+	Knights_Move best_move; // Chosen at random among the moves with the best evaluation
+	int evaluation;
+	long positions; // Number of positions evaluated so far
+	double seconds; // Time taken so far
+	int move_count;
+	Knights_Line moves[KNIGHTS_MAX_MOVES]; // Best first, from the point of view of the side to move
+} Knights_Result;
+
+typedef void (*Knights_Progress)(const Knights_Result *result, void *data);
+// Called, from the thread which began the search, each time a search to a greater depth completes
+
+KNIGHTS_API Knights_Engine *knights_engine_create(const Knights_Options *options);
+// Returns an engine set to the starting position, or NULL if memory could not be allocated or the board size is not
+// supported.  If "options" is NULL, the defaults are used.  The library holds a build of the engine specialised for
+// each board size, and the engine uses the one for its size.
+KNIGHTS_API void knights_engine_destroy(Knights_Engine *engine);
+KNIGHTS_API int knights_engine_board_size(Knights_Engine *engine);
+KNIGHTS_API int knights_engine_threads(Knights_Engine *engine); // Greatest number of search threads running at once
+KNIGHTS_API int knights_engine_processors(Knights_Engine *engine); // Number of processors the engine may run on
+KNIGHTS_API int knights_engine_remove_host_budget(const char *name);
+// Removes the shared memory object of a host-wide budget (see "Knights_Options"), which is otherwise left behind when
+// the last engine using it is destroyed.  Engines still using it keep their budget, but engines created afterwards
+// with the same name count their threads in a new one.  Returns zero on failure (e.g., if there is no such object).
+
+KNIGHTS_API void knights_engine_new_game(Knights_Engine *engine); // Returns to the starting position
+KNIGHTS_API int knights_engine_set_position(Knights_Engine *engine, uint64_t white_pieces, uint64_t black_pieces, unsigned checks_and_turn);
+// Sets the position from its compressed form (as printed by "a.out -v"), and starts a new game from it.  Returns
+// zero, leaving the engine unchanged, if the position is invalid.
+KNIGHTS_API int knights_engine_play(Knights_Engine *engine, Knights_Move move);
+// Makes a move in the current position; returns zero, leaving the engine unchanged, if the move is illegal or the
+// game is over
+KNIGHTS_API Knights_Status knights_engine_status(Knights_Engine *engine);
+// Whether the game is over, including draws by repetition and by the length of the game
+KNIGHTS_API void knights_engine_position(Knights_Engine *engine, Knights_Position *position);
+
+KNIGHTS_API int knights_engine_search(Knights_Engine *engine, const Knights_Limits *limits, Knights_Progress progress, void *data, Knights_Result *result);
+// Searches the current position.  Returns zero (with "result" zeroed) if the game is over, or the search was stopped
+// before any depth was completed; otherwise fills "result" with the deepest completed search.  "progress" may be NULL.
+KNIGHTS_API void knights_engine_stop(Knights_Engine *engine);
+// Abandons the search (or solve) in progress.  A search with a time limit returns the deepest depth it completed; one
+// without, or one stopped before any depth was completed, returns zero with "result" zeroed (see
+// "knights_engine_search").  A solve returns "KNIGHTS_ONGOING" (see "knights_engine_solve").  May be called from a
+// signal handler.
+
+KNIGHTS_API long knights_engine_save_table(Knights_Engine *engine, const char *path, int min_depth);
+// Writes the positions in the hash table searched to at least "min_depth" to a snapshot file, and returns their
+// number, or -1 on failure
+KNIGHTS_API int knights_engine_load_table(Knights_Engine *engine, const char *path, long *loaded);
+// Adds the positions of a snapshot file, written for the same variant and board size, to the hash table, so that
+// later searches start warm, and stores their number in "*loaded".  Returns "KNIGHTS_TABLE_OK", or the reason the
+// file could not be read.  Must not be called while the engine searches.
+KNIGHTS_API void knights_engine_clear_table(Knights_Engine *engine);
+// Empties the hash table, so that the next search starts cold.  Must not be called while the engine searches.
+
+KNIGHTS_API int knights_engine_open_proof_table(Knights_Engine *engine, const char *path, long megabytes, int *resumed);
+// Maps the file in which the solver keeps its proof and disproof numbers, so that the operating system may page it out
+// to disk.  If the file exists, the work in it is resumed (and "*resumed" is set); otherwise a table of "megabytes"
+// megabytes is created.  Returns "KNIGHTS_TABLE_OK", or the reason the table could not be opened.
+KNIGHTS_API Knights_Status knights_engine_solve(Knights_Engine *engine, long limit, long *positions);
+// Proves the result of the current position under perfect play, using the proof table (which must be open), and adds
+// the number of positions visited to "*positions".  Returns "KNIGHTS_ONGOING" if the result is still unknown when the
+// engine's threads have visited "limit" positions between them (unless it is zero), or the solve is stopped; the
+// table keeps what was found, so that solving again resumes the proof.
+KNIGHTS_API int knights_engine_build_book(Knights_Engine *engine, Knights_Status result, long limit, long *positions);
+// Adds the winning side's strategy from the current position (whose "result", found by "knights_engine_solve", must
+// be a win) to the book: a winning move for every position that side may face.  Positions whose results are missing
+// from the proof table are solved again, visiting at most "limit" positions (counted in "*positions") if it is
+// nonzero.  Returns zero if the book could not be completed.
+KNIGHTS_API long knights_engine_write_book(Knights_Engine *engine, const char *path);
+// Writes the book to a file, and returns the number of positions in it, or -1 on failure
+KNIGHTS_API int knights_engine_read_book(Knights_Engine *engine, const char *path);
+// Adds the positions of a book file, written for the same variant and board size, to the book.  Returns zero if the
+// file could not be read or does not match.
+KNIGHTS_API int knights_engine_book_move(Knights_Engine *engine, Knights_Move *move);
+// Finds the book's move in the current position, if any; returns zero if there is none
+
+#endif